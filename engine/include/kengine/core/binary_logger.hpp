@@ -0,0 +1,70 @@
+#ifndef KENGINE_CORE_BINARY_LOGGER_HPP
+#define KENGINE_CORE_BINARY_LOGGER_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/core/logging.hpp>
+#include <kengine/core/fileio/mapped_file.hpp>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace kengine::core {
+
+// "KLOG" files, little endian: a BinaryLogHeader, then entries each starting with a BinaryLogEntry byte.
+//   Format: u8 kind, u8 padding, u16 length, u32 id, then the format string, defined before its first use in the file
+//   Record: u8 kind, s8 severity, u16 argument bytes, u32 format id, u64 time, then the packed arguments of the LogRecord
+// A zero byte or the end of the file ends the entries.
+enum class BinaryLogEntry : kengine::u8 {
+	End = 0,
+	Format = 1,
+	Record = 2,
+};
+
+struct BinaryLogHeader {
+	char magic[4];
+	kengine::u32 version;
+
+	// increases with every file a logger opens, orders a rotated set
+	kengine::u64 sequence;
+
+	// record times are steady clock nanoseconds, these two taken together map them to wall clock time
+	kengine::u64 steadyNanoseconds;
+	kengine::u64 systemNanoseconds;
+};
+
+constexpr kengine::u32 binaryLogVersion = 1;
+constexpr kengine::usize binaryLogFormatEntrySize = 8;
+constexpr kengine::usize binaryLogRecordEntrySize = 16;
+
+// Writes records without formatting them: each format string goes into the file once, after that a record is its id,
+// severity, timestamp and raw argument bytes. Files are named <basePath>.<n>.klog with n cycling through fileCount, so
+// the oldest file is overwritten once they are all full. tools/logdecode turns them back into text.
+class BinaryLogger : public ILogger {
+public:
+	BinaryLogger(std::string const& basePath, kengine::usize fileSize = 64 << 20, kengine::u32 fileCount = 4);
+	~BinaryLogger() override;
+
+	void log(LogSeverity severity, std::string const& message) override;
+	bool logRecord(kengine::u8 const* record) override;
+
+private:
+	bool _rotate();
+
+	std::mutex _mutex;
+
+	std::string _basePath;
+	kengine::usize _fileSize;
+	kengine::u32 _fileCount;
+
+	fileio::MappedFile _file;
+	kengine::usize _offset = 0;
+	kengine::u64 _sequence = 0;
+
+	// ids of the formats already defined in the current file
+	std::unordered_map<char const*, kengine::u32> _formats;
+};
+
+} // namespace kengine::core
+
+#endif
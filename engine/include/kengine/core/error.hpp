@@ -0,0 +1,53 @@
+#ifndef KENGINE_CORE_ERROR_HPP
+#define KENGINE_CORE_ERROR_HPP
+
+#include <kengine/types.hpp>
+
+namespace kengine::core {
+
+enum class ErrorCode : kengine::u16 {
+	None = 0,
+	Unknown = 1,
+	InvalidArgument = 2,
+	InvalidState = 3,
+	NotFound = 4,
+	AlreadyExists = 5,
+	OutOfMemory = 6,
+	Unsupported = 7,
+	TypeMismatch = 8,
+};
+
+inline char const* errorCodeAsString(ErrorCode code) {
+	switch (code) {
+	case ErrorCode::None:
+		return "None";
+	case ErrorCode::Unknown:
+		return "Unknown";
+	case ErrorCode::InvalidArgument:
+		return "InvalidArgument";
+	case ErrorCode::InvalidState:
+		return "InvalidState";
+	case ErrorCode::NotFound:
+		return "NotFound";
+	case ErrorCode::AlreadyExists:
+		return "AlreadyExists";
+	case ErrorCode::OutOfMemory:
+		return "OutOfMemory";
+	case ErrorCode::Unsupported:
+		return "Unsupported";
+	case ErrorCode::TypeMismatch:
+		return "TypeMismatch";
+	default:
+		return "Unknown";
+	}
+}
+
+// message points at a string literal, so an error costs nothing to create or copy
+struct Error {
+	ErrorCode code = ErrorCode::None;
+	char const* message = "";
+};
+
+} // namespace kengine::core
+
+#endif
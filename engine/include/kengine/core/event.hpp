@@ -3,19 +3,24 @@
 
 #include <kengine/types.hpp>
 #include <kengine/singleton.hpp>
+#include <kengine/core/event_queue.hpp>
+#include <kengine/core/exception.hpp>
 #include <kengine/core/logging.hpp>
-#include <kengine/core/uuid.hpp>
+#include <kengine/core/tag_slot.hpp>
+#include <kengine/util/delegate.hpp>
+#include <kengine/util/hash.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
-#include <string>
+#include <string_view>
+#include <vector>
 
 namespace kengine::core {
 
-struct IEventData {
-	IEventData() = default;
-	virtual ~IEventData() = default;
-};
-
 template<typename T>
 struct EventData {
 	EventData() = default;
@@ -24,104 +29,329 @@ struct EventData {
 	T data;
 };
 
-using EventCallback = bool(*)(IEventData*);
+// listeners see the payload type-erased, the typed subscribe/trigger pair restores it
+using EventDelegate = util::Delegate<bool(void const*)>;
 
-struct ITagData {
-	ITagData() = default;
-	virtual ~ITagData() = default;
+struct ListenerId {
+	kengine::u32 event = EventId::invalidIndex;
+	kengine::u32 serial = 0;
 
-	virtual const UUID& getUUID() const {
-		static UUID uuid = UUID(0);
-		return uuid;
-	}
+	bool isValid() const { return event != EventId::invalidIndex; }
 };
 
+namespace detail {
+
+// one address per payload type, compared to catch triggers and tag accesses that don't match
 template<typename T>
-struct UUIDTagData : public ITagData {
-	const UUID& getUUID() const override { return getUUIDStatic(); }
+struct EventPayloadType {
+	static constexpr char key = 0;
+};
+
+} // namespace detail
 
-	static const UUID& getUUIDStatic() {
-		static UUID uuid = UUID();
-		return uuid;
+class EventSystem : public Singleton<EventSystem> {
+public:
+	// per payload type and frame, events queued past it are dropped
+	static constexpr kengine::u32 eventQueueCapacity = 1024;
+	static constexpr kengine::u32 maxEventQueues = 64;
+	static constexpr kengine::u32 maxTags = 256;
+
+	// returns the existing id when the name was registered before
+	EventId registerEvent(kengine::u64 nameHash) {
+		auto it = m_eventIndices.find(nameHash);
+		if (it != m_eventIndices.end()) {
+			return EventId{ it->second };
+		}
+
+		EventId event{ static_cast<kengine::u32>(m_events.size()) };
+		m_eventIndices.emplace(nameHash, event.index);
+		m_events.emplace_back();
+		return event;
 	}
-};
 
-template<typename T>
-struct TagData : public UUIDTagData<TagData> {
-	TagData() = default;
-	TagData(const T& data) : data(data) {}
+	EventId registerEvent(std::string_view eventName) {
+		return registerEvent(util::hash(eventName));
+	}
 
-	operator T&() { return data; }
-	operator const T&() const { return data; }
+	EventId getEvent(kengine::u64 nameHash) const {
+		auto it = m_eventIndices.find(nameHash);
+		if (it == m_eventIndices.end()) {
+			return EventId();
+		}
 
-	T& operator=(const T& data) {
-		this->data = data;
-		return *this;
+		return EventId{ it->second };
 	}
 
-	T data;
-};
+	EventId getEvent(std::string_view eventName) const {
+		return getEvent(util::hash(eventName));
+	}
 
-class EventSystem : public Singleton<EventSystem> {
-public:
-	void createEventCallback(std::string eventName, EventCallback callback) {
-		if (m_eventCallbacks.find(eventName) != m_eventCallbacks.end()) {
-			Logger::get().logf(LogSeverity::Warning, "Event {} already exists", eventName);
+	// higher priorities run first and equal ones in subscription order, a listener returning true consumes the event
+	// listeners must not subscribe or unsubscribe to the event they are handling
+	template<typename T, typename F>
+	ListenerId subscribe(EventId event, F&& listener, kengine::s32 priority = 0) {
+		using Callable = std::decay_t<F>;
+		static_assert(std::is_invocable_r_v<bool, Callable&, T const&>, "Event listener must be callable as bool(T const&)");
+
+		return _subscribe(event, &detail::EventPayloadType<T>::key, EventDelegate([listener = Callable(std::forward<F>(listener))](void const* payload) mutable {
+			return listener(*static_cast<T const*>(payload));
+		}), priority);
+	}
+
+	template<typename T, typename Object>
+	ListenerId subscribe(EventId event, Object* object, bool (Object::*method)(T const&), kengine::s32 priority = 0) {
+		return _subscribe(event, &detail::EventPayloadType<T>::key, EventDelegate([object, method](void const* payload) {
+			return (object->*method)(*static_cast<T const*>(payload));
+		}), priority);
+	}
+
+	template<typename T, typename F>
+	ListenerId subscribe(std::string_view eventName, F&& listener, kengine::s32 priority = 0) {
+		return subscribe<T>(registerEvent(eventName), std::forward<F>(listener), priority);
+	}
+
+	void unsubscribe(ListenerId listener) {
+		if (listener.event >= m_events.size()) {
 			return;
 		}
 
-		m_eventCallbacks[eventName] = callback;
+		std::vector<Listener>& listeners = m_events[listener.event].listeners;
+		auto it = std::find_if(listeners.begin(), listeners.end(), [&listener](Listener const& entry) {
+			return entry.serial == listener.serial;
+		});
+
+		if (it != listeners.end()) {
+			listeners.erase(it);
+		}
 	}
 
-	void triggerEvent(std::string eventName, IEventData* data) {
-		if (m_eventCallbacks.find(eventName) == m_eventCallbacks.end()) {
-			Logger::get().logf(LogSeverity::Warning, "Event {} does not exist", eventName);
-			return;
+	// the payload stays in the caller's frame, returns true when a listener consumed the event
+	template<typename T>
+	bool triggerEvent(EventId event, T const& payload) {
+		if (event.index >= m_events.size()) {
+			KENGINE_LOG_LIMITED(Events, Warning, "Event id {} does not exist", event.index);
+			return false;
 		}
-		
-		m_eventCallbacks[eventName](data);
+
+		return _dispatch(event, &detail::EventPayloadType<T>::key, &payload);
 	}
 
+	// hashes the name on every call, hold on to the EventId from registerEvent on hot paths
 	template<typename T>
-	void createTag(std::string tagName) {
-		static_assert(std::is_base_of_v<UUIDTagData<T>, T>, "T must inherit from UUIDTagData");
+	bool triggerEvent(std::string_view eventName, T const& payload) {
+		EventId event = getEvent(eventName);
+		if (!event.isValid()) {
+			KENGINE_LOG_LIMITED(Events, Warning, "Event {} does not exist", eventName);
+			return false;
+		}
 
-		if (m_tagData.find(tagName) != m_tagData.end()) {
-			Logger::get().logf(LogSeverity::Warning, "Tag {} already exists", tagName);
-			return;
+		return _dispatch(event, &detail::EventPayloadType<T>::key, &payload);
+	}
+
+	// safe from any thread and never blocks, listeners run at the next dispatchQueuedEvents
+	// false when this frame's queue for T is full, drops are reported when the queue is dispatched
+	template<typename T>
+	bool queueEvent(EventId event, T const& payload) {
+		return _queue<T>().push(event, payload);
+	}
+
+	// dispatches the queued events one payload type at a time, events queued meanwhile wait for the next call
+	void dispatchQueuedEvents() {
+		kengine::u32 count = m_queueCount.load(std::memory_order_acquire);
+		for (kengine::u32 i = 0; i < count; ++i) {
+			IEventQueue& queue = *m_queues[i];
+			char const* payloadType = queue.getPayloadType();
+
+			kengine::u32 dropped = queue.flush(EventQueueDispatch([this, payloadType](EventId event, void const* payload) {
+				if (event.index >= m_events.size()) {
+					KENGINE_LOG_LIMITED(Events, Warning, "Event id {} does not exist", event.index);
+					return;
+				}
+
+				_dispatch(event, payloadType, payload);
+			}));
+
+			if (dropped > 0) {
+				KENGINE_LOG_LIMITED(Events, Warning, "Dropped {} queued events, the queue holds {} per frame", dropped, eventQueueCapacity);
+			}
+		}
+	}
+
+	// tags are created and their ids resolved up front, reading and writing is then safe from any thread
+	// returns the existing id when the name was created before with the same type
+	template<typename T>
+	TagId createTag(kengine::u64 nameHash, T const& initialValue = T()) {
+		static_assert(std::is_trivially_copyable_v<T>, "Tag values must be trivially copyable");
+
+		auto it = m_tagIndices.find(nameHash);
+		if (it != m_tagIndices.end()) {
+			if (m_tags[it->second]->getPayloadType() != &detail::EventPayloadType<T>::key) {
+				KENGINE_LOG(Events, Warning, "Tag id {} already exists with a different type", it->second);
+				return TagId();
+			}
+
+			return TagId{ it->second };
+		}
+
+		kengine::u32 index = m_tagCount.load(std::memory_order_relaxed);
+		if (index >= maxTags) {
+			throw Exception("EventSystem: more than {} tags", maxTags);
 		}
 
-		m_tagData[tagName] = new T();
+		m_tags[index] = std::make_unique<TagSlot>(&detail::EventPayloadType<T>::key, sizeof(T));
+		m_tags[index]->write(initialValue);
+		m_tagIndices.emplace(nameHash, index);
+		m_tagCount.store(index + 1, std::memory_order_release);
+
+		return TagId{ index };
 	}
 
 	template<typename T>
-	void writeTag(std::string tagName, T const& data) {
-		static_assert(std::is_base_of_v<UUIDTagData<T>, T>, "T must inherit from UUIDTagData");
+	TagId createTag(std::string_view tagName, T const& initialValue = T()) {
+		return createTag<T>(util::hash(tagName), initialValue);
+	}
 
-		if (m_tagData.find(tagName) == m_tagData.end()) {
-			Logger::get().logf(LogSeverity::Warning, "Tag {} does not exist", tagName);
-			return;
+	TagId getTag(kengine::u64 nameHash) const {
+		auto it = m_tagIndices.find(nameHash);
+		if (it == m_tagIndices.end()) {
+			return TagId();
 		}
 
-		*(static_cast<T*>(m_tagData[tagName])->data) = data;
+		return TagId{ it->second };
+	}
+
+	TagId getTag(std::string_view tagName) const {
+		return getTag(util::hash(tagName));
 	}
 
 	template<typename T>
-	T const& readTag(std::string tagName) {
-		static_assert(std::is_base_of_v<UUIDTagData<T>, T>, "T must inherit from UUIDTagData");
+	bool writeTag(TagId tag, T const& value) {
+		TagSlot* slot = _tagSlot<T>(tag);
+		if (slot == nullptr) {
+			return false;
+		}
+
+		slot->write(value);
+		return true;
+	}
 
-		if (m_tagData.find(tagName) == m_tagData.end()) {
-			Logger::get().logf(LogSeverity::Warning, "Tag {} does not exist", tagName);
-			return T();
+	// copies the latest published value out, value is left untouched when the tag is missing
+	template<typename T>
+	bool readTag(TagId tag, T& value) const {
+		TagSlot const* slot = _tagSlot<T>(tag);
+		if (slot == nullptr) {
+			return false;
 		}
 
-		return *(static_cast<T*>(m_tagData[tagName])->data);
+		slot->read(value);
+		return true;
 	}
 
 private:
-	std::unordered_map<std::string, EventCallback> m_eventCallbacks;
-	std::unordered_map<std::string, IEventData*> m_eventData;
-	std::unordered_map<std::string, ITagData*> m_tagData;
+	struct Listener {
+		EventDelegate delegate;
+		kengine::s32 priority;
+		kengine::u32 serial;
+	};
+
+	struct EventSlot {
+		// fixed by the first subscriber
+		char const* payloadType = nullptr;
+		std::vector<Listener> listeners;
+		kengine::u32 nextSerial = 0;
+	};
+
+	ListenerId _subscribe(EventId event, char const* payloadType, EventDelegate const& delegate, kengine::s32 priority) {
+		if (event.index >= m_events.size()) {
+			KENGINE_LOG(Events, Warning, "Event id {} was not registered", event.index);
+			return ListenerId();
+		}
+
+		EventSlot& slot = m_events[event.index];
+		if (slot.payloadType != nullptr && slot.payloadType != payloadType) {
+			KENGINE_LOG(Events, Warning, "Event id {} already has listeners taking a different payload type", event.index);
+			return ListenerId();
+		}
+		slot.payloadType = payloadType;
+
+		ListenerId id{ event.index, slot.nextSerial++ };
+		auto position = std::upper_bound(slot.listeners.begin(), slot.listeners.end(), priority, [](kengine::s32 priority, Listener const& listener) {
+			return priority > listener.priority;
+		});
+		slot.listeners.insert(position, Listener{ delegate, priority, id.serial });
+
+		return id;
+	}
+
+	template<typename T>
+	EventQueue<T>& _queue() {
+		static EventQueue<T>& queue = _addQueue(std::make_unique<EventQueue<T>>(&detail::EventPayloadType<T>::key, eventQueueCapacity));
+		return queue;
+	}
+
+	template<typename Queue>
+	Queue& _addQueue(std::unique_ptr<Queue> queue) {
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+
+		kengine::u32 index = m_queueCount.load(std::memory_order_relaxed);
+		if (index >= maxEventQueues) {
+			throw Exception("EventSystem: more than {} queued payload types", maxEventQueues);
+		}
+
+		Queue& result = *queue;
+		m_queues[index] = std::move(queue);
+		m_queueCount.store(index + 1, std::memory_order_release);
+		return result;
+	}
+
+	template<typename T>
+	TagSlot* _tagSlot(TagId tag) const {
+		if (tag.index >= m_tagCount.load(std::memory_order_acquire)) {
+			KENGINE_LOG_LIMITED(Events, Warning, "Tag id {} does not exist", tag.index);
+			return nullptr;
+		}
+
+		TagSlot* slot = m_tags[tag.index].get();
+		if (slot->getPayloadType() != &detail::EventPayloadType<T>::key) {
+			KENGINE_LOG_LIMITED(Events, Warning, "Tag id {} accessed as a different type", tag.index);
+			return nullptr;
+		}
+
+		return slot;
+	}
+
+	bool _dispatch(EventId event, char const* payloadType, void const* payload) {
+		EventSlot const& slot = m_events[event.index];
+		if (slot.payloadType != payloadType) {
+			if (slot.payloadType != nullptr) {
+				KENGINE_LOG_LIMITED(Events, Warning, "Event id {} triggered with a payload type its listeners don't take", event.index);
+			}
+			return false;
+		}
+
+		for (Listener const& listener : slot.listeners) {
+			if (listener.delegate(payload)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	std::unordered_map<kengine::u64, kengine::u32> m_eventIndices;
+	std::vector<EventSlot> m_events;
+
+	// fixed size so dispatchQueuedEvents can walk it while another thread adds a queue
+	std::array<std::unique_ptr<IEventQueue>, maxEventQueues> m_queues;
+	std::atomic<kengine::u32> m_queueCount = 0;
+	std::mutex m_queueMutex;
+
+	// fixed size for the same reason, slots never move once created
+	std::array<std::unique_ptr<TagSlot>, maxTags> m_tags;
+	std::atomic<kengine::u32> m_tagCount = 0;
+	std::unordered_map<kengine::u64, kengine::u32> m_tagIndices;
 };
 
-} // namespace kengine::core
\ No newline at end of file
+} // namespace kengine::core
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef KENGINE_CORE_EVENT_QUEUE_HPP
+#define KENGINE_CORE_EVENT_QUEUE_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/util/delegate.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+namespace kengine::core {
+
+// interned event handle, resolved once from the name so a trigger is an array index
+struct EventId {
+	static constexpr kengine::u32 invalidIndex = ~0u;
+
+	kengine::u32 index = invalidIndex;
+
+	bool isValid() const { return index != invalidIndex; }
+
+	bool operator==(EventId const& other) const { return index == other.index; }
+	bool operator!=(EventId const& other) const { return index != other.index; }
+};
+
+using EventQueueDispatch = util::Delegate<void(EventId, void const*)>;
+
+class IEventQueue {
+public:
+	virtual ~IEventQueue() = default;
+
+	virtual char const* getPayloadType() const = 0;
+
+	// hands every event queued since the last flush to dispatch, in push order, returns how many were dropped
+	virtual kengine::u32 flush(EventQueueDispatch const& dispatch) = 0;
+};
+
+// deferred events of one payload type, stored contiguously and double buffered
+// any thread can push without locking, a single thread flushes
+template<typename T>
+class EventQueue : public IEventQueue {
+	static_assert(std::is_default_constructible_v<T> && std::is_copy_assignable_v<T>, "Queued event payloads must be default constructible and copy assignable");
+
+public:
+	EventQueue(char const* payloadType, kengine::u32 capacity) : _payloadType(payloadType), _capacity(capacity) {
+		for (Buffer& buffer : _buffers) {
+			buffer.entries = std::make_unique<Entry[]>(capacity);
+		}
+	}
+
+	char const* getPayloadType() const override { return _payloadType; }
+
+	// never blocks, false when this frame's buffer is full and the event was dropped
+	bool push(EventId event, T const& payload) {
+		// announce the write before using the buffer, and back off if a flush retired it meanwhile
+		kengine::u32 active;
+		for (;;) {
+			active = _active.load();
+			_buffers[active].writers.fetch_add(1);
+			if (_active.load() == active) {
+				break;
+			}
+			_buffers[active].writers.fetch_sub(1);
+		}
+
+		Buffer& buffer = _buffers[active];
+		kengine::u32 index = buffer.count.fetch_add(1, std::memory_order_relaxed);
+		bool stored = index < _capacity;
+		if (stored) {
+			buffer.entries[index].event = event;
+			buffer.entries[index].payload = payload;
+		} else {
+			_dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		buffer.writers.fetch_sub(1, std::memory_order_release);
+		return stored;
+	}
+
+	kengine::u32 flush(EventQueueDispatch const& dispatch) override {
+		// new pushes go to the other buffer, including the ones listeners make while this one is dispatched
+		kengine::u32 retired = _active.load(std::memory_order_relaxed);
+		_active.store(retired ^ 1);
+
+		Buffer& buffer = _buffers[retired];
+		while (buffer.writers.load() != 0) {
+			std::this_thread::yield();
+		}
+
+		kengine::u32 count = std::min(buffer.count.load(std::memory_order_relaxed), _capacity);
+		for (kengine::u32 i = 0; i < count; ++i) {
+			dispatch(buffer.entries[i].event, &buffer.entries[i].payload);
+		}
+		buffer.count.store(0, std::memory_order_relaxed);
+
+		return _dropped.exchange(0, std::memory_order_relaxed);
+	}
+
+private:
+	struct Entry {
+		EventId event;
+		T payload;
+	};
+
+	struct Buffer {
+		std::unique_ptr<Entry[]> entries;
+		std::atomic<kengine::u32> count = 0;
+		std::atomic<kengine::u32> writers = 0;
+	};
+
+	char const* _payloadType;
+	kengine::u32 _capacity;
+
+	Buffer _buffers[2];
+	std::atomic<kengine::u32> _active = 0;
+	std::atomic<kengine::u32> _dropped = 0;
+};
+
+} // namespace kengine::core
+
+#endif
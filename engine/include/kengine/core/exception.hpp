@@ -2,36 +2,81 @@
 #define KENGINE_CORE_EXCEPTION_HPP
 
 #include <exception>
+#include <mutex>
+#include <kengine/core/error.hpp>
 #include <kengine/core/logging.hpp>
 
 namespace kengine::core {
 
+// Keeps the format and its packed arguments and only builds the message when what() asks for it. Nothing is logged
+// on construction, whoever handles the exception decides with log().
 class Exception : public std::exception {
 public:
-	Exception() {
-		Logger::get().logf(LogSeverity::Error, "KEngine Exception (no message)");
+	// arguments past this are truncated like in a log record
+	static constexpr kengine::usize recordCapacity = 256;
+
+	Exception() : Exception("KEngine Exception (no message)") {}
+
+	// format has to be a string literal, the exception reads it again in what()
+	template<kengine::usize N, typename... Args>
+	Exception(char const (&format)[N], Args const&... args) {
+		LogRecordWriter writer(_record, LogSeverity::Error, static_cast<char const*>(format), recordCapacity);
+		(writer.put(args), ...);
+		writer.finish(logTimestamp());
 	}
 
-	Exception(char const* message) : _message(message) {
-		Logger::get().logf(LogSeverity::Error, "KEngine Exception: {}", message);
+	Exception(std::string const& message) {
+		LogRecordWriter writer(_record, LogSeverity::Error, "{}", recordCapacity);
+		writer.putString(message);
+		writer.finish(logTimestamp());
+
+		// the record may have truncated it, keep the full message
+		std::call_once(_formatOnce, [this, &message] { _message = message; });
 	}
 
-	Exception(std::string const& message) : _message(message) {
-		Logger::get().logf(LogSeverity::Error, "KEngine Exception: {}", message);
+	Exception(Error const& error) : _code(error.code) {
+		LogRecordWriter writer(_record, LogSeverity::Error, error.message, recordCapacity);
+		writer.finish(logTimestamp());
 	}
 
-	template<typename... Args>
-	Exception(std::string const& format, Args... args) {
-		std::string fmt = "KEngine Exception: ";
-		Logger::get().logf(LogSeverity::Error, fmt + format, args...);
+	// the once_flag can't be copied, a copy takes the formatted message along instead
+	Exception(Exception const& other) : std::exception(other), _code(other._code) {
+		std::memcpy(_record, other._record, recordCapacity);
+		std::call_once(_formatOnce, [this, &other] { _message = other.what(); });
 	}
 
-	char const* what() const noexcept override { return _message.c_str(); }
+	Exception& operator=(Exception const&) = delete;
+
+	// safe to call from several threads, the first call formats and the others wait for it
+	char const* what() const noexcept override {
+		std::call_once(_formatOnce, [this] {
+			try {
+				formatLogRecord(_message, _record);
+			} catch (...) {
+				_message.clear();
+			}
+		});
+
+		return _message.c_str();
+	}
+
+	ErrorCode getCode() const { return _code; }
+
+	// queues the packed record, formatting happens on the logging thread like for any other message
+	void log(LogSeverity severity = LogSeverity::Error) const {
+		kengine::u8 record[recordCapacity];
+		std::memcpy(record, _record, recordCapacity);
+		std::memcpy(record + offsetof(LogRecord, severity), &severity, sizeof(LogSeverity));
+		Logger::get().submit(record);
+	}
 
 private:
-	std::string _message;
+	kengine::u8 _record[recordCapacity];
+	mutable std::string _message;
+	mutable std::once_flag _formatOnce;
+	ErrorCode _code = ErrorCode::Unknown;
 };
 
 } // namespace kengine::core
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,83 @@
+#ifndef KENGINE_CORE_EXPECTED_HPP
+#define KENGINE_CORE_EXPECTED_HPP
+
+#include <kengine/core/error.hpp>
+#include <kengine/core/exception.hpp>
+
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace kengine::core {
+
+// a value or the Error that kept it from being produced, for paths that report failure without throwing
+template<typename T>
+class Expected {
+	static_assert(!std::is_same_v<T, Error>, "Expected<Error> cannot tell a value from an error");
+
+public:
+	Expected(T const& value) : _storage(std::in_place_index<0>, value) {}
+	Expected(T&& value) : _storage(std::in_place_index<0>, std::move(value)) {}
+	Expected(Error const& error) : _storage(std::in_place_index<1>, error) {}
+
+	bool hasValue() const { return _storage.index() == 0; }
+	explicit operator bool() const { return hasValue(); }
+
+	// throws the error as an Exception when there is no value
+	T& value() {
+		_check();
+		return *std::get_if<0>(&_storage);
+	}
+
+	T const& value() const {
+		_check();
+		return *std::get_if<0>(&_storage);
+	}
+
+	T valueOr(T const& fallback) const { return hasValue() ? *std::get_if<0>(&_storage) : fallback; }
+
+	Error const& error() const {
+		static Error const none;
+		return hasValue() ? none : *std::get_if<1>(&_storage);
+	}
+
+	T& operator*() { return *std::get_if<0>(&_storage); }
+	T const& operator*() const { return *std::get_if<0>(&_storage); }
+	T* operator->() { return std::get_if<0>(&_storage); }
+	T const* operator->() const { return std::get_if<0>(&_storage); }
+
+private:
+	void _check() const {
+		if (!hasValue()) {
+			throw Exception(*std::get_if<1>(&_storage));
+		}
+	}
+
+	std::variant<T, Error> _storage;
+};
+
+// Expected<void>: success, or the Error explaining the failure
+class Status {
+public:
+	Status() = default;
+	Status(Error const& error) : _error(error) {}
+
+	bool ok() const { return _error.code == ErrorCode::None; }
+	explicit operator bool() const { return ok(); }
+
+	Error const& error() const { return _error; }
+
+	// throws the error as an Exception unless ok
+	void check() const {
+		if (!ok()) {
+			throw Exception(_error);
+		}
+	}
+
+private:
+	Error _error;
+};
+
+} // namespace kengine::core
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef KENGINE_CORE_FILEIO_MAPPED_FILE_HPP
+#define KENGINE_CORE_FILEIO_MAPPED_FILE_HPP
+
+#include <string>
+
+#include <kengine/types.hpp>
+#include <kengine/macros.hpp>
+
+namespace kengine::core::fileio {
+
+// a file of fixed size mapped writable into memory, writes land in the page cache without a syscall each
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+
+	// creates or truncates the file at path and maps size bytes of it, zero filled
+	bool create(std::string const& path, kengine::usize size);
+
+	// unmaps and cuts the file down to usedSize, so a partly written file has no zeroed tail
+	void close(kengine::usize usedSize);
+	void close() { close(_size); }
+
+	bool isOpen() const { return _data != nullptr; }
+	kengine::u8* getData() { return _data; }
+	kengine::usize getSize() const { return _size; }
+
+private:
+	kengine::u8* _data = nullptr;
+	kengine::usize _size = 0;
+
+#ifdef KENGINE_PLATFORM_WINDOWS
+	void* _file = nullptr;
+	void* _mapping = nullptr;
+#else
+	int _descriptor = -1;
+#endif
+};
+
+} // namespace kengine::core::fileio
+
+#endif
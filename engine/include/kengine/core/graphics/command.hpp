@@ -0,0 +1,178 @@
+#ifndef KENGINE_CORE_GRAPHICS_COMMAND_HPP
+#define KENGINE_CORE_GRAPHICS_COMMAND_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/core/transform.hpp>
+#include <kengine/core/graphics/mesh.hpp>
+#include <kengine/util/math/vector.hpp>
+
+#include <vector>
+#include <new>
+#include <type_traits>
+
+namespace kengine::core::graphics {
+
+enum class CommandType : kengine::u8 {
+	Clear = 0,
+	Viewport = 1,
+	State = 2,
+	Draw = 3,
+};
+
+enum class RenderPass : kengine::u8 {
+	Clear = 0,
+	Opaque = 1,
+	Transparent = 2,
+	Overlay = 3,
+};
+
+enum ClearFlags : kengine::u32 {
+	ClearColor = 1 << 0,
+	ClearDepth = 1 << 1,
+};
+
+enum RenderStateFlags : kengine::u32 {
+	StateDepthTest = 1 << 0,
+	StateDepthWrite = 1 << 1,
+	StateBlend = 1 << 2,
+	StateCullBackFaces = 1 << 3,
+};
+
+// sort key layout, most significant first: pass (8 bits), material (24 bits), depth (32 bits)
+constexpr kengine::u64 makeSortKey(RenderPass pass, kengine::u32 material, kengine::u32 depth) {
+	return (static_cast<kengine::u64>(pass) << 56) | (static_cast<kengine::u64>(material & 0xFFFFFF) << 32) | depth;
+}
+
+// maps a non-negative view depth to sortable key bits, back-to-front flips the order for blending
+kengine::u32 sortKeyDepth(kengine::f32 depth, bool backToFront = false);
+
+struct ClearCommand {
+	static constexpr CommandType type = CommandType::Clear;
+
+	util::math::Vector<f32, 4> color = { 0.0f, 0.0f, 0.0f, 1.0f };
+	kengine::f32 depth = 1.0f;
+	kengine::u32 flags = ClearColor | ClearDepth;
+};
+
+struct ViewportCommand {
+	static constexpr CommandType type = CommandType::Viewport;
+
+	kengine::s32 x = 0;
+	kengine::s32 y = 0;
+	kengine::u32 width = 0;
+	kengine::u32 height = 0;
+};
+
+struct StateCommand {
+	static constexpr CommandType type = CommandType::State;
+
+	kengine::u32 state = StateDepthTest | StateDepthWrite | StateCullBackFaces;
+};
+
+struct DrawCommand {
+	static constexpr CommandType type = CommandType::Draw;
+
+	IMesh* mesh = nullptr;
+	kengine::u32 material = 0;
+	kengine::u32 firstIndex = 0;
+	kengine::u32 indexCount = 0;
+	Transform transform;
+};
+
+struct CommandPacket {
+	CommandType type;
+	kengine::u32 size;
+
+	template<typename T>
+	T const& as() const {
+		return *reinterpret_cast<T const*>(reinterpret_cast<kengine::u8 const*>(this) + payloadOffset);
+	}
+
+	static constexpr kengine::usize alignment = 16;
+	static constexpr kengine::usize payloadOffset = alignment;
+};
+
+struct CommandEntry {
+	kengine::u64 key;
+	CommandPacket const* packet;
+};
+
+// linear, fixed-capacity command recorder, meant to be owned and filled by a single thread
+class CommandBuffer {
+public:
+	CommandBuffer(kengine::usize byteCapacity = 256 * 1024, kengine::usize commandCapacity = 8192);
+	~CommandBuffer();
+
+	CommandBuffer(CommandBuffer const&) = delete;
+	CommandBuffer& operator=(CommandBuffer const&) = delete;
+
+	// returns nullptr once the buffer is full, the command is dropped in that case
+	template<typename T>
+	T* push(kengine::u64 key) {
+		static_assert(std::is_trivially_destructible_v<T>, "Commands must be trivially destructible");
+		static_assert(alignof(T) <= CommandPacket::alignment, "Command alignment too large");
+
+		kengine::usize size = CommandPacket::payloadOffset + sizeof(T);
+		size = (size + CommandPacket::alignment - 1) & ~(CommandPacket::alignment - 1);
+		if (_offset + size > _byteCapacity || _count >= _commandCapacity) {
+			_overflowed = true;
+			return nullptr;
+		}
+
+		CommandPacket* packet = reinterpret_cast<CommandPacket*>(_data + _offset);
+		packet->type = T::type;
+		packet->size = static_cast<kengine::u32>(size);
+
+		_entries[_count++] = { key, packet };
+		_offset += size;
+
+		return new (reinterpret_cast<kengine::u8*>(packet) + CommandPacket::payloadOffset) T();
+	}
+
+	ClearCommand* clear(kengine::u64 key, util::math::Vector<f32, 4> const& color, kengine::u32 flags = ClearColor | ClearDepth);
+	ViewportCommand* viewport(kengine::u64 key, kengine::s32 x, kengine::s32 y, kengine::u32 width, kengine::u32 height);
+	StateCommand* state(kengine::u64 key, kengine::u32 state);
+	DrawCommand* draw(kengine::u64 key, IMesh* mesh, Transform const& transform, kengine::u32 material = 0);
+	// snapshots the object's mesh and transform, the object itself isn't referenced after recording
+	DrawCommand* draw(kengine::u64 key, IObject const& object, kengine::u32 material = 0);
+
+	void reset();
+
+	CommandEntry const* getEntries() const { return _entries; }
+	kengine::usize getCommandCount() const { return _count; }
+	kengine::usize getByteSize() const { return _offset; }
+	bool hasOverflowed() const { return _overflowed; }
+
+private:
+	kengine::u8* _data = nullptr;
+	kengine::usize _byteCapacity = 0;
+	kengine::usize _offset = 0;
+
+	CommandEntry* _entries = nullptr;
+	kengine::usize _commandCapacity = 0;
+	kengine::usize _count = 0;
+
+	bool _overflowed = false;
+};
+
+// gathers the command buffers submitted for a frame and orders them by sort key
+class CommandQueue {
+public:
+	void submit(CommandBuffer const& buffer);
+
+	// stable LSD radix sort on the 64-bit keys, byte passes where all keys agree are skipped
+	void sort();
+	void clear();
+
+	CommandEntry const* begin() const { return _entries.data(); }
+	CommandEntry const* end() const { return _entries.data() + _entries.size(); }
+	kengine::usize size() const { return _entries.size(); }
+
+private:
+	std::vector<CommandEntry> _entries;
+	std::vector<CommandEntry> _scratch;
+};
+
+} // namespace kengine::core::graphics
+
+#endif
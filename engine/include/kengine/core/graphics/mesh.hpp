@@ -3,9 +3,12 @@
 
 #include <kengine/types.hpp>
 #include <kengine/core/transform.hpp>
+#include <kengine/util/span.hpp>
 #include <kengine/util/math/vector.hpp>
 
 #include <vector>
+#include <algorithm>
+#include <cmath>
 
 namespace kengine::core::graphics {
 
@@ -15,6 +18,30 @@ struct Vertex {
 	util::math::Vector<float, 2> texCoords;
 };
 
+// a range of the mesh's index buffer, error is the object-space deviation from the full detail mesh
+struct MeshLOD {
+	kengine::u32 firstIndex = 0;
+	kengine::u32 indexCount = 0;
+	kengine::f32 error = 0.0f;
+};
+
+// picks the coarsest level whose error projects to at most pixelThreshold pixels,
+// projectionScale is the viewport height in pixels divided by 2 * tan(fovY / 2)
+inline kengine::usize selectLOD(util::Span<MeshLOD const> lods, kengine::f32 distance, kengine::f32 objectScale, kengine::f32 projectionScale, kengine::f32 pixelThreshold = 1.0f) {
+	distance = std::max(distance, 1e-4f);
+
+	kengine::usize selected = 0;
+	for (kengine::usize i = 1; i < lods.size(); ++i) {
+		if (lods[i].error * objectScale * projectionScale / distance > pixelThreshold) {
+			break;
+		}
+
+		selected = i;
+	}
+
+	return selected;
+}
+
 class IMesh {
 protected:
 	IMesh() = default;
@@ -22,20 +49,53 @@ protected:
 	virtual ~IMesh() = default;
 
 public:
-	virtual std::vector<Vertex> getVertices() = 0;
-	virtual void setVertices(std::vector<Vertex> const& vertices) = 0;
+	virtual util::Span<Vertex const> getVertices() const = 0;
+	virtual void setVertices(util::Span<Vertex const> vertices) = 0;
+
+	virtual util::Span<kengine::u32 const> getIndices() const = 0;
+	virtual void setIndices(util::Span<kengine::u32 const> indices) = 0;
+
+	// LOD 0 is the full detail mesh, without LODs the whole index buffer is one level
+	util::Span<MeshLOD const> getLODs() const { return _lods; }
+	void setLODs(util::Span<MeshLOD const> lods) { _lods.assign(lods.begin(), lods.end()); }
 
-	virtual std::vector<kengine::usize> getIndices() = 0;
-	virtual void setIndices(std::vector<kengine::usize> const& indices) = 0;
+	kengine::u32 getBaseIndexCount() const {
+		return _lods.empty() ? static_cast<kengine::u32>(getIndices().size()) : _lods[0].indexCount;
+	}
+
+protected:
+	std::vector<MeshLOD> _lods;
 };
 
+// the level of mesh to draw with transform, seen from viewPosition
+inline MeshLOD selectLOD(IMesh const& mesh, Transform const& transform, util::math::Vector<f32, 3> const& viewPosition, kengine::f32 projectionScale, kengine::f32 pixelThreshold = 1.0f) {
+	util::Span<MeshLOD const> lods = mesh.getLODs();
+	if (lods.empty()) {
+		return MeshLOD{ 0, mesh.getBaseIndexCount(), 0.0f };
+	}
+
+	util::math::Vector<f32, 3> offset = transform.position - viewPosition;
+	kengine::f32 distance = std::sqrt(offset.dot(offset));
+	kengine::f32 scale = std::max(std::fabs(transform.scale[0]), std::max(std::fabs(transform.scale[1]), std::fabs(transform.scale[2])));
+
+	return lods[selectLOD(lods, distance, scale, projectionScale, pixelThreshold)];
+}
+
 class IObject {
 public:
 	IObject(IMesh* mesh) : _mesh(mesh) {}
 
-	IMesh* getMesh() { return _mesh; }
+	IMesh* getMesh() const { return _mesh; }
 	void setMesh(IMesh* mesh) { _mesh = mesh; }
 
+	MeshLOD selectLOD(util::math::Vector<f32, 3> const& viewPosition, kengine::f32 projectionScale, kengine::f32 pixelThreshold = 1.0f) const {
+		if (_mesh == nullptr) {
+			return MeshLOD();
+		}
+
+		return graphics::selectLOD(*_mesh, transform, viewPosition, projectionScale, pixelThreshold);
+	}
+
 	Transform transform;
 
 private:
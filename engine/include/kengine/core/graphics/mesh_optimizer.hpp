@@ -0,0 +1,53 @@
+#ifndef KENGINE_CORE_GRAPHICS_MESH_OPTIMIZER_HPP
+#define KENGINE_CORE_GRAPHICS_MESH_OPTIMIZER_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/core/graphics/mesh.hpp>
+#include <kengine/util/span.hpp>
+
+#include <vector>
+
+namespace kengine::core::graphics {
+
+// CPU-side triangle list, the unit the offline/import processing stages work on
+struct MeshData {
+	std::vector<Vertex> vertices;
+	std::vector<kengine::u32> indices;
+};
+
+struct MeshOptimizationStats {
+	kengine::usize vertexCountBefore = 0;
+	kengine::usize vertexCountAfter = 0;
+
+	// average cache miss ratio, post-transform cache misses per triangle (0.5 is ideal, 3.0 is worst)
+	kengine::f32 acmrBefore = 0;
+	kengine::f32 acmrAfter = 0;
+};
+
+// simulates a FIFO post-transform cache
+kengine::f32 computeACMR(util::Span<kengine::u32 const> indices, kengine::usize vertexCount, kengine::u32 cacheSize = 16);
+
+// the stages below log and leave the mesh untouched when an index is out of range for the vertices
+
+// merges bitwise identical vertices, returns the number of vertices removed
+kengine::usize weldVertices(MeshData& mesh);
+
+// reorders triangles for post-transform cache hits (Forsyth's linear-speed vertex cache optimization)
+void optimizeVertexCache(util::Span<kengine::u32> indices, kengine::usize vertexCount);
+
+// reorders triangle clusters so outward-facing ones are drawn first, keeping ACMR within threshold times the input's,
+// cacheSize is the FIFO the clusters are found and the ACMR is measured with
+void optimizeOverdraw(util::Span<kengine::u32> indices, util::Span<Vertex const> vertices, kengine::f32 threshold = 1.05f, kengine::u32 cacheSize = 16);
+
+// reorders vertices by first use so fetches walk the vertex buffer linearly, unreferenced vertices are dropped
+void optimizeVertexFetch(MeshData& mesh);
+
+// runs every stage above in order
+MeshOptimizationStats optimizeMesh(MeshData& mesh);
+// triangles are only reordered within each LOD's index range so the ranges stay valid, stats are for LOD 0
+MeshOptimizationStats optimizeMesh(MeshData& mesh, util::Span<MeshLOD const> lods);
+MeshOptimizationStats optimizeMesh(IMesh& mesh);
+
+} // namespace kengine::core::graphics
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef KENGINE_CORE_GRAPHICS_MESH_SIMPLIFIER_HPP
+#define KENGINE_CORE_GRAPHICS_MESH_SIMPLIFIER_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/core/graphics/mesh.hpp>
+#include <kengine/core/graphics/mesh_optimizer.hpp>
+#include <kengine/util/span.hpp>
+
+#include <vector>
+
+namespace kengine::core::graphics {
+
+// quadric error metric edge collapse onto existing vertices, so the result indexes the same vertex buffer;
+// border and attribute seam vertices are locked to keep the silhouette and avoid cracks.
+// Stops at targetIndexCount or once the next collapse would exceed targetError (object-space distance).
+std::vector<kengine::u32> simplifyMesh(util::Span<Vertex const> vertices, util::Span<kengine::u32 const> indices, kengine::usize targetIndexCount, kengine::f32 targetError, kengine::f32* resultError = nullptr);
+
+// appends up to maxLevels simplified index lists to mesh.indices, each about reduction times the previous one
+std::vector<MeshLOD> generateLODs(MeshData& mesh, kengine::u32 maxLevels = 4, kengine::f32 reduction = 0.5f);
+
+// generates every mesh's LOD chain in parallel, one mesh per task
+std::vector<std::vector<MeshLOD>> generateLODs(util::Span<MeshData> meshes, kengine::u32 maxLevels = 4, kengine::f32 reduction = 0.5f);
+
+// convenience for import, simplifies the mesh's current indices and stores the chain on it
+void generateLODs(IMesh& mesh, kengine::u32 maxLevels = 4, kengine::f32 reduction = 0.5f);
+
+} // namespace kengine::core::graphics
+
+#endif
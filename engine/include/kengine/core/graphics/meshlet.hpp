@@ -0,0 +1,70 @@
+#ifndef KENGINE_CORE_GRAPHICS_MESHLET_HPP
+#define KENGINE_CORE_GRAPHICS_MESHLET_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/core/graphics/mesh.hpp>
+#include <kengine/util/span.hpp>
+#include <kengine/util/math/vector.hpp>
+
+#include <vector>
+
+namespace kengine::core::graphics {
+
+// a contiguous run of triangles in the mesh's index buffer
+struct Meshlet {
+	kengine::u32 firstIndex = 0;
+	kengine::u32 triangleCount = 0;
+	kengine::u32 vertexCount = 0;
+};
+
+// the cone cutoff is 1 when the triangles face too many directions to ever be backface culled
+struct MeshletBounds {
+	util::math::Vector<f32, 3> center;
+	kengine::f32 radius = 0.0f;
+
+	util::math::Vector<f32, 3> coneAxis;
+	kengine::f32 coneCutoff = 1.0f;
+};
+
+// MeshletBounds as structure of arrays, padded to a multiple of 4 for the culler
+struct MeshletCullData {
+	std::vector<kengine::f32> centerX;
+	std::vector<kengine::f32> centerY;
+	std::vector<kengine::f32> centerZ;
+	std::vector<kengine::f32> radius;
+	std::vector<kengine::f32> axisX;
+	std::vector<kengine::f32> axisY;
+	std::vector<kengine::f32> axisZ;
+	std::vector<kengine::f32> cutoff;
+	kengine::usize count = 0;
+
+	static MeshletCullData build(util::Span<MeshletBounds const> bounds);
+};
+
+// planes point inwards, (x, y, z) is the normal and w the distance
+struct Frustum {
+	util::math::Vector<f32, 4> planes[6];
+
+	// extracts the planes of a column-major view projection matrix
+	static Frustum fromMatrix(kengine::f32 const* viewProjection);
+};
+
+struct MeshletRange {
+	kengine::u32 firstIndex = 0;
+	kengine::u32 indexCount = 0;
+};
+
+// grows meshlets over shared vertices and reorders the triangles so each one is contiguous,
+// run on the vertex cache optimized index buffer; firstIndex is relative to the span
+std::vector<Meshlet> buildMeshlets(util::Span<kengine::u32> indices, util::Span<Vertex const> vertices, kengine::u32 maxVertices = 64, kengine::u32 maxTriangles = 124);
+
+MeshletBounds computeMeshletBounds(util::Span<kengine::u32 const> indices, util::Span<Vertex const> vertices);
+std::vector<MeshletBounds> computeMeshletBounds(util::Span<Meshlet const> meshlets, util::Span<kengine::u32 const> indices, util::Span<Vertex const> vertices);
+
+// tests meshlets against the frustum and their normal cones, appending the visible index ranges with neighbours merged;
+// frustum and camera position are in the mesh's object space. Returns the number of visible meshlets
+kengine::usize cullMeshlets(MeshletCullData const& data, util::Span<Meshlet const> meshlets, Frustum const& frustum, util::math::Vector<f32, 3> const& cameraPosition, std::vector<MeshletRange>& visible);
+
+} // namespace kengine::core::graphics
+
+#endif
@@ -2,11 +2,14 @@
 #define KENGINE_CORE_GRAPHICS_RENDERER_HPP
 
 #include <stdexcept>
+#include <algorithm>
 
 #include <kengine/singleton.hpp>
 #include <kengine/core/exception.hpp>
 #include <kengine/core/window/window.hpp>
 #include <kengine/core/graphics/mesh.hpp>
+#include <kengine/core/graphics/vertex_format.hpp>
+#include <kengine/core/graphics/command.hpp>
 
 namespace kengine::core::graphics {
 
@@ -16,11 +19,32 @@ public:
 	RendererException(const char* message) : Exception(message) {}
 };
 
+enum class RendererBackend {
+	GL41 = 0,
+	Null = 1,
+};
+
+struct RenderStatistics {
+	kengine::u64 frameCount = 0;
+
+	kengine::usize commandCount = 0;
+	kengine::usize clearCount = 0;
+	kengine::usize viewportCount = 0;
+	kengine::usize stateChangeCount = 0;
+	kengine::usize drawCount = 0;
+	kengine::usize triangleCount = 0;
+
+	kengine::f64 sortMilliseconds = 0;
+	kengine::f64 replayMilliseconds = 0;
+};
+
 class IRenderer;
 
 class Renderer : public Singleton<Renderer> {
 public:
-	IRenderer& create(window::IWindow& window);
+	IRenderer& create(window::IWindow& window, RendererBackend backend = RendererBackend::GL41);
+	// headless backends only, no window or GPU is required
+	IRenderer& create(RendererBackend backend);
 	void destroy(IRenderer& renderer);
 };
 
@@ -32,8 +56,47 @@ protected:
 
 public:
 	virtual void render() = 0;
-	virtual IMesh* createMesh() = 0;
+
+	// the buffer's commands are replayed, in sort key order, by the next render(); it must not be reset or destroyed before then
+	virtual void submit(CommandBuffer const& commands) = 0;
+
+	IMesh* createMesh() { return createMesh(VertexLayout::standard()); }
+	// layout is how the backend stores the mesh's vertices, backends keeping meshes on the CPU ignore it
+	virtual IMesh* createMesh(VertexLayout const& layout) = 0;
+	virtual void destroyMesh(IMesh* mesh) = 0;
 	virtual IObject* createObject(IMesh* mesh) = 0;
+
+	RenderStatistics const& getStatistics() const { return _statistics; }
+
+	// view the LODs of draws are selected for, projectionScale is the viewport height in pixels divided by 2 * tan(fovY / 2)
+	void setView(util::math::Vector<f32, 3> const& position, kengine::f32 projectionScale, kengine::f32 lodPixelThreshold = 1.0f) {
+		_viewPosition = position;
+		_projectionScale = projectionScale;
+		_lodPixelThreshold = lodPixelThreshold;
+	}
+
+protected:
+	// the index range a draw replays, the LOD for the current view unless the command gives a range
+	MeshLOD _selectDrawRange(DrawCommand const& command) const {
+		if (command.indexCount != 0) {
+			return MeshLOD{ command.firstIndex, command.indexCount, 0.0f };
+		}
+
+		// selected from what was recorded, the object may already be simulating the next frame
+		if (command.firstIndex == 0 && !command.mesh->getLODs().empty()) {
+			return selectLOD(*command.mesh, command.transform, _viewPosition, _projectionScale, _lodPixelThreshold);
+		}
+
+		kengine::u32 baseIndexCount = command.mesh->getBaseIndexCount();
+		return MeshLOD{ command.firstIndex, std::max(baseIndexCount, command.firstIndex) - command.firstIndex, 0.0f };
+	}
+
+	RenderStatistics _statistics;
+
+	util::math::Vector<f32, 3> _viewPosition = { 0.0f, 0.0f, 0.0f };
+	// 600 pixels tall with a 60 degree vertical field of view
+	kengine::f32 _projectionScale = 519.6f;
+	kengine::f32 _lodPixelThreshold = 1.0f;
 };
 
 } // namespace kengine::core
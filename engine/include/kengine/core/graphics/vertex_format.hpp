@@ -0,0 +1,90 @@
+#ifndef KENGINE_CORE_GRAPHICS_VERTEX_FORMAT_HPP
+#define KENGINE_CORE_GRAPHICS_VERTEX_FORMAT_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/core/graphics/mesh.hpp>
+#include <kengine/util/span.hpp>
+#include <kengine/util/math/vector.hpp>
+
+namespace kengine::core::graphics {
+
+enum class PositionFormat : kengine::u8 {
+	// 3 x f32, 12 bytes
+	Float32 = 0,
+	// 4 x f16 with unused w, 8 bytes
+	Half = 1,
+	// 4 x snorm16 relative to the mesh bounds with unused w, 8 bytes
+	Snorm16 = 2,
+};
+
+enum class NormalFormat : kengine::u8 {
+	// 3 x f32, 12 bytes
+	Float32 = 0,
+	// octahedral mapping, 2 x snorm16, 4 bytes
+	Octahedral16 = 1,
+};
+
+enum class TexCoordFormat : kengine::u8 {
+	// 2 x f32, 8 bytes
+	Float32 = 0,
+	// 2 x f16, 4 bytes
+	Half = 1,
+	// 2 x unorm16, 4 bytes, clamped to [0, 1] so not suitable for tiling coordinates
+	Unorm16 = 2,
+};
+
+enum class IndexFormat : kengine::u8 {
+	U16 = 0,
+	U32 = 1,
+};
+
+struct VertexLayout {
+	PositionFormat position = PositionFormat::Float32;
+	NormalFormat normal = NormalFormat::Float32;
+	TexCoordFormat texCoords = TexCoordFormat::Float32;
+
+	kengine::u32 positionOffset = 0;
+	kengine::u32 normalOffset = 0;
+	kengine::u32 texCoordsOffset = 0;
+	kengine::u32 stride = 0;
+
+	static VertexLayout make(PositionFormat position, NormalFormat normal, TexCoordFormat texCoords);
+
+	// same precision as graphics::Vertex
+	static VertexLayout full() { return make(PositionFormat::Float32, NormalFormat::Float32, TexCoordFormat::Float32); }
+	// 16 bytes per vertex, half texcoords keep tiling coordinates outside [0, 1] working
+	static VertexLayout standard() { return make(PositionFormat::Snorm16, NormalFormat::Octahedral16, TexCoordFormat::Half); }
+	// 16 bytes per vertex, texcoords limited to [0, 1] in exchange for uniform precision
+	static VertexLayout compact() { return make(PositionFormat::Snorm16, NormalFormat::Octahedral16, TexCoordFormat::Unorm16); }
+
+	bool operator==(VertexLayout const& other) const {
+		return position == other.position && normal == other.normal && texCoords == other.texCoords;
+	}
+
+	bool operator!=(VertexLayout const& other) const { return !(*this == other); }
+};
+
+// axis-aligned, extent is half the size on each axis
+struct MeshBounds {
+	util::math::Vector<f32, 3> center;
+	util::math::Vector<f32, 3> extent;
+};
+
+MeshBounds computeBounds(util::Span<Vertex const> vertices);
+
+kengine::usize indexFormatSize(IndexFormat format);
+IndexFormat chooseIndexFormat(util::Span<kengine::u32 const> indices);
+
+// out must hold vertices.size() * layout.stride bytes
+void encodeVertices(util::Span<Vertex const> vertices, VertexLayout const& layout, MeshBounds const& bounds, kengine::u8* out);
+void decodeVertices(kengine::u8 const* data, kengine::usize count, VertexLayout const& layout, MeshBounds const& bounds, Vertex* out);
+
+// out must hold indices.size() * indexFormatSize(format) bytes
+void encodeIndices(util::Span<kengine::u32 const> indices, IndexFormat format, void* out);
+
+kengine::u16 floatToHalf(kengine::f32 value);
+kengine::f32 halfToFloat(kengine::u16 value);
+
+} // namespace kengine::core::graphics
+
+#endif
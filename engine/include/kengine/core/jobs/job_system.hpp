@@ -0,0 +1,141 @@
+#ifndef KENGINE_CORE_JOBS_JOB_SYSTEM_HPP
+#define KENGINE_CORE_JOBS_JOB_SYSTEM_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/singleton.hpp>
+#include <kengine/core/jobs/work_stealing_deque.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kengine::core::jobs {
+
+using JobFunction = void(*)(void* data);
+
+// counts unfinished jobs, wait on it to join a batch
+class Counter {
+public:
+	kengine::u32 get() const { return _value.load(std::memory_order_acquire); }
+	bool isDone() const { return get() == 0; }
+
+private:
+	friend class JobSystem;
+
+	std::atomic<kengine::u32> _value = 0;
+};
+
+constexpr kengine::u32 maxContinuations = 4;
+
+// one cache line, recycled from a ring owned by the JobSystem
+struct alignas(64) Job {
+	JobFunction function = nullptr;
+	void* data = nullptr;
+	Counter* counter = nullptr;
+
+	// dependencies still running, plus one until the job is submitted
+	std::atomic<kengine::u32> pending = 0;
+
+	std::atomic<kengine::u16> continuationCount = 0;
+
+	// set from create until the job starts running, a ring never hands out a live slot
+	std::atomic<bool> live = false;
+
+	Job* continuations[maxContinuations] = {};
+};
+
+static_assert(sizeof(Job) == 64, "Job must stay one cache line");
+
+struct JobSystemConfig {
+	// 0 uses one worker per hardware thread besides the calling one
+	kengine::u32 workerCount = 0;
+	bool pinWorkers = false;
+};
+
+class JobSystem : public Singleton<JobSystem> {
+public:
+	static constexpr kengine::usize dequeCapacity = 4096;
+
+	// jobs are recycled from one ring per worker plus one shared by foreign threads,
+	// create waits (running other jobs) when its ring wraps onto a job that has not started yet
+	static constexpr kengine::usize jobsPerRing = 4096;
+
+	~JobSystem();
+
+	// the calling thread becomes worker 0 and runs jobs while it waits
+	void init(JobSystemConfig const& config = {});
+
+	// runs every job still queued before the workers stop, so no counter is left waiting
+	void shutdown();
+
+	bool isRunning() const { return _running.load(std::memory_order_acquire); }
+	kengine::u32 getWorkerCount() const { return static_cast<kengine::u32>(_workers.size()); }
+
+	// the returned job is held until submit(), so dependencies can be added first;
+	// counter, when given, is raised now and lowered once the job finished.
+	// a created job must be submitted, its slot stays taken until it ran
+	Job* create(JobFunction function, void* data, Counter* counter = nullptr);
+
+	// `after` is released only once `before` finished, both must be unsubmitted
+	void addDependency(Job* before, Job* after);
+
+	void submit(Job* job);
+
+	// create and submit in one go
+	Job* run(JobFunction function, void* data, Counter* counter = nullptr);
+
+	// runs other jobs until the counter reaches zero, never blocks the thread
+	void wait(Counter const& counter);
+
+	// worker index of the calling thread, or invalidWorker for foreign threads
+	kengine::u32 getWorkerIndex() const;
+
+	static constexpr kengine::u32 invalidWorker = ~0u;
+
+private:
+	struct JobRing {
+		std::unique_ptr<Job[]> jobs = std::make_unique<Job[]>(jobsPerRing);
+		kengine::usize next = 0;
+	};
+
+	struct alignas(64) Worker {
+		WorkStealingDeque<Job, dequeCapacity> deque;
+		JobRing ring;
+		std::thread thread;
+		kengine::u32 stealSeed = 0;
+	};
+
+	void _workerMain(kengine::u32 index);
+
+	Job* _allocate();
+
+	// pops local work, then steals, then falls back to the injection queue
+	Job* _next(kengine::u32 index);
+	void _execute(Job* job);
+	void _push(Job* job);
+
+	std::vector<std::unique_ptr<Worker>> _workers;
+
+	// jobs created by threads the system does not own, or before init
+	std::mutex _foreignMutex;
+	JobRing _foreignRing;
+
+	// submissions from threads the system does not own
+	std::mutex _injectionMutex;
+	std::deque<Job*> _injected;
+
+	std::mutex _sleepMutex;
+	std::condition_variable _wake;
+	std::atomic<kengine::u32> _sleeping = 0;
+	std::atomic<kengine::s64> _queued = 0;
+
+	std::atomic<bool> _running = false;
+};
+
+} // namespace kengine::core::jobs
+
+#endif
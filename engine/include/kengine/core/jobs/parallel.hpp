@@ -0,0 +1,203 @@
+#ifndef KENGINE_CORE_JOBS_PARALLEL_HPP
+#define KENGINE_CORE_JOBS_PARALLEL_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/core/jobs/job_system.hpp>
+#include <kengine/util/span.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace kengine::core::jobs {
+
+constexpr kengine::usize cacheLineSize = 64;
+
+// tiny grains are raised so one call never makes more chunks (and reduce partials) than this
+constexpr kengine::usize maxChunks = 1024;
+
+namespace detail {
+
+inline kengine::usize clampGrain(kengine::usize count, kengine::usize grain) {
+	return std::max({ grain, static_cast<kengine::usize>(1), (count + maxChunks - 1) / maxChunks });
+}
+
+// chunk 0 is [begin, first), every later chunk is grain elements starting at first
+struct ChunkLayout {
+	kengine::usize begin;
+	kengine::usize end;
+	kengine::usize first;
+	kengine::usize grain;
+	kengine::usize count;
+
+	ChunkLayout(kengine::usize begin, kengine::usize end, kengine::usize first, kengine::usize grain)
+		: begin(begin), end(end), first(std::min(std::max(first, begin + 1), end)), grain(std::max<kengine::usize>(grain, 1)) {
+		count = begin >= end ? 0 : 1 + (this->end - this->first + this->grain - 1) / this->grain;
+	}
+
+	kengine::usize chunkBegin(kengine::usize chunk) const { return chunk == 0 ? begin : first + (chunk - 1) * grain; }
+	kengine::usize chunkEnd(kengine::usize chunk) const { return chunk == 0 ? first : std::min(end, first + chunk * grain); }
+};
+
+template<typename Function>
+struct ChunkContext {
+	ChunkLayout layout;
+	Function* function;
+	std::atomic<kengine::usize> next = 0;
+
+	// every job pulls chunks until none are left, so uneven chunks balance out
+	static void run(void* data) {
+		ChunkContext* context = static_cast<ChunkContext*>(data);
+		for (kengine::usize chunk = context->next.fetch_add(1, std::memory_order_relaxed); chunk < context->layout.count; chunk = context->next.fetch_add(1, std::memory_order_relaxed)) {
+			(*context->function)(chunk, context->layout.chunkBegin(chunk), context->layout.chunkEnd(chunk));
+		}
+	}
+};
+
+// function(chunk, begin, end), the calling thread works along and returns once every chunk ran
+template<typename Function>
+void dispatchChunks(ChunkLayout const& layout, Function& function) {
+	JobSystem& jobSystem = JobSystem::get();
+	kengine::usize workers = jobSystem.isRunning() ? jobSystem.getWorkerCount() : 1;
+
+	if (layout.count <= 1 || workers <= 1) {
+		for (kengine::usize chunk = 0; chunk < layout.count; ++chunk) {
+			function(chunk, layout.chunkBegin(chunk), layout.chunkEnd(chunk));
+		}
+		return;
+	}
+
+	ChunkContext<Function> context{ layout, &function };
+	Counter counter;
+
+	kengine::usize helpers = std::min(workers, layout.count) - 1;
+	for (kengine::usize i = 0; i < helpers; ++i) {
+		jobSystem.run(&ChunkContext<Function>::run, &context, &counter);
+	}
+
+	ChunkContext<Function>::run(&context);
+	jobSystem.wait(counter);
+}
+
+// first chunk boundary at or after begin whose element starts a cache line
+template<typename T>
+kengine::usize alignedFirst(T const* data, kengine::usize begin, kengine::usize grain) {
+	if (cacheLineSize % sizeof(T) != 0 || data == nullptr) {
+		return begin + grain;
+	}
+
+	kengine::usize misalignment = reinterpret_cast<std::uintptr_t>(data + begin) % cacheLineSize;
+	kengine::usize head = misalignment == 0 ? 0 : (cacheLineSize - misalignment) / sizeof(T);
+	return begin + head + grain;
+}
+
+// grain rounded up to whole cache lines of T
+template<typename T>
+kengine::usize alignedGrain(kengine::usize grain) {
+	kengine::usize perLine = std::max<kengine::usize>(cacheLineSize / sizeof(T), 1);
+	return (std::max<kengine::usize>(grain, 1) + perLine - 1) / perLine * perLine;
+}
+
+template<typename T>
+struct alignas(cacheLineSize) PaddedValue {
+	T value;
+};
+
+} // namespace detail
+
+// calls function(begin, end) over chunks of about grain indices, ranges up to grain run on the calling thread
+template<typename Function>
+void parallelFor(kengine::usize begin, kengine::usize end, kengine::usize grain, Function&& function) {
+	if (end <= begin) {
+		return;
+	}
+
+	if (end - begin <= grain) {
+		function(begin, end);
+		return;
+	}
+
+	grain = detail::clampGrain(end - begin, grain);
+
+	auto chunk = [&function](kengine::usize, kengine::usize chunkBegin, kengine::usize chunkEnd) {
+		function(chunkBegin, chunkEnd);
+	};
+
+	detail::dispatchChunks(detail::ChunkLayout(begin, end, begin + grain, grain), chunk);
+}
+
+// as above over the indices of data, chunk boundaries fall on cache lines so writes into data never share one
+template<typename T, typename Function>
+void parallelFor(util::Span<T> data, kengine::usize grain, Function&& function) {
+	if (data.size() <= grain) {
+		if (!data.empty()) {
+			function(static_cast<kengine::usize>(0), data.size());
+		}
+		return;
+	}
+
+	grain = detail::alignedGrain<T>(detail::clampGrain(data.size(), grain));
+
+	auto chunk = [&function](kengine::usize, kengine::usize chunkBegin, kengine::usize chunkEnd) {
+		function(chunkBegin, chunkEnd);
+	};
+
+	detail::dispatchChunks(detail::ChunkLayout(0, data.size(), detail::alignedFirst(data.data(), 0, grain), grain), chunk);
+}
+
+// map(begin, end) -> T per chunk, partials are padded to their own cache line and folded in chunk order with combine(T, T),
+// so the result does not depend on the worker count
+template<typename T, typename Map, typename Combine>
+T parallelReduce(kengine::usize begin, kengine::usize end, kengine::usize grain, T identity, Map&& map, Combine&& combine) {
+	if (end <= begin) {
+		return identity;
+	}
+
+	if (end - begin <= grain) {
+		return combine(identity, map(begin, end));
+	}
+
+	grain = detail::clampGrain(end - begin, grain);
+	detail::ChunkLayout layout(begin, end, begin + grain, grain);
+	std::vector<detail::PaddedValue<T>> partials(layout.count, detail::PaddedValue<T>{ identity });
+
+	auto chunk = [&map, &partials](kengine::usize index, kengine::usize chunkBegin, kengine::usize chunkEnd) {
+		partials[index].value = map(chunkBegin, chunkEnd);
+	};
+
+	detail::dispatchChunks(layout, chunk);
+
+	T result = identity;
+	for (detail::PaddedValue<T> const& partial : partials) {
+		result = combine(result, partial.value);
+	}
+	return result;
+}
+
+template<typename T, typename U, typename Map, typename Combine>
+T parallelReduce(util::Span<U> data, kengine::usize grain, T identity, Map&& map, Combine&& combine) {
+	if (data.size() <= grain) {
+		return data.empty() ? identity : combine(identity, map(static_cast<kengine::usize>(0), data.size()));
+	}
+
+	grain = detail::alignedGrain<U>(detail::clampGrain(data.size(), grain));
+	detail::ChunkLayout layout(0, data.size(), detail::alignedFirst(data.data(), 0, grain), grain);
+	std::vector<detail::PaddedValue<T>> partials(layout.count, detail::PaddedValue<T>{ identity });
+
+	auto chunk = [&map, &partials](kengine::usize index, kengine::usize chunkBegin, kengine::usize chunkEnd) {
+		partials[index].value = map(chunkBegin, chunkEnd);
+	};
+
+	detail::dispatchChunks(layout, chunk);
+
+	T result = identity;
+	for (detail::PaddedValue<T> const& partial : partials) {
+		result = combine(result, partial.value);
+	}
+	return result;
+}
+
+} // namespace kengine::core::jobs
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef KENGINE_CORE_JOBS_WORK_STEALING_DEQUE_HPP
+#define KENGINE_CORE_JOBS_WORK_STEALING_DEQUE_HPP
+
+#include <kengine/types.hpp>
+
+#include <atomic>
+
+namespace kengine::core::jobs {
+
+// Chase-Lev deque with a fixed power of two capacity: the owner pushes and pops at the bottom,
+// any other thread steals from the top. Ordering follows Le et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models" (2013)
+template<typename T, kengine::usize Capacity>
+class WorkStealingDeque {
+	static_assert((Capacity & (Capacity - 1)) == 0, "WorkStealingDeque capacity must be a power of two");
+
+public:
+	// owner only, false when full
+	bool push(T* item) {
+		kengine::s64 bottom = _bottom.load(std::memory_order_relaxed);
+		kengine::s64 top = _top.load(std::memory_order_acquire);
+		if (bottom - top >= static_cast<kengine::s64>(Capacity)) {
+			return false;
+		}
+
+		_items[bottom & (Capacity - 1)].store(item, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// owner only
+	T* pop() {
+		kengine::s64 bottom = _bottom.load(std::memory_order_relaxed) - 1;
+		_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		kengine::s64 top = _top.load(std::memory_order_relaxed);
+
+		if (top > bottom) {
+			_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		T* item = _items[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+		if (top == bottom) {
+			// last item, race the thieves for it
+			if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				item = nullptr;
+			}
+			_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+		return item;
+	}
+
+	T* steal() {
+		kengine::s64 top = _top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		kengine::s64 bottom = _bottom.load(std::memory_order_acquire);
+
+		if (top >= bottom) {
+			return nullptr;
+		}
+
+		T* item = _items[top & (Capacity - 1)].load(std::memory_order_relaxed);
+		if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return nullptr;
+		}
+
+		return item;
+	}
+
+	kengine::usize size() const {
+		kengine::s64 size = _bottom.load(std::memory_order_relaxed) - _top.load(std::memory_order_relaxed);
+		return size > 0 ? static_cast<kengine::usize>(size) : 0;
+	}
+
+private:
+	alignas(64) std::atomic<kengine::s64> _top = 0;
+	alignas(64) std::atomic<kengine::s64> _bottom = 0;
+	alignas(64) std::atomic<T*> _items[Capacity] = {};
+};
+
+} // namespace kengine::core::jobs
+
+#endif
@@ -2,20 +2,76 @@
 #define KENGINE_CORE_KENGINE_HPP
 
 #include <kengine/macros.hpp>
+#include <kengine/types.hpp>
+#include <kengine/core/graphics/command.hpp>
+#include <kengine/core/jobs/job_system.hpp>
+#include <kengine/core/timing.hpp>
+
+#include <atomic>
+#include <memory>
+#include <vector>
 
 namespace kengine::core {
 
+// everything one simulated frame hands to the render thread
+struct FrameContext {
+	kengine::u64 index = 0;
+	kengine::f64 time = 0;
+	kengine::f64 deltaTime = 0;
+
+	// blend factor between the last two fixed steps, for interpolating what gets drawn
+	kengine::f64 alpha = 0;
+
+	graphics::CommandBuffer commands;
+};
+
+// runs on a worker thread, one frame ahead of the renderer when the latency cap allows it
+using FrameUpdate = void(*)(FrameContext& frame, void* userData);
+
+// called zero or more times per frame before FrameUpdate, always with the same step
+using FixedUpdate = void(*)(kengine::f64 step, void* userData);
+
+struct KEngineConfig {
+	// frames the simulation may run ahead of the one being rendered, 1 keeps update and render in lockstep
+	kengine::u32 maxFrameLatency = 2;
+
+	kengine::f64 fixedTimestep = 1.0 / 60.0;
+
+	// the main loop sleeps to this frame time, 0 runs unpaced
+	kengine::f64 targetFrameTime = 1.0 / 60.0;
+
+	FixedUpdate fixedUpdate = nullptr;
+	FrameUpdate update = nullptr;
+	void* userData = nullptr;
+};
+
 class KEngine {
 public:
 	KEngine() = default;
+	KEngine(KEngineConfig const& config) : _config(config) {}
 	~KEngine() = default;
 
 	void run();
 
 private:
+	static void _simulate(void* data);
+
+	// starts the simulation job if it is idle and a frame slot is free
+	void _kickSimulation();
+
+	KEngineConfig _config;
+
+	std::vector<std::unique_ptr<FrameContext>> _frames;
+	FixedTimestep _timestep;
+	kengine::f64 _simulationTime = 0;
+
+	jobs::Counter _simulation;
 
+	std::atomic<kengine::u64> _simulatedFrames = 0;
+	std::atomic<kengine::u64> _renderedFrames = 0;
+	std::atomic<bool> _running = false;
 };
 
 } // namespace kengine::core
 
-#endif
\ No newline at end of file
+#endif
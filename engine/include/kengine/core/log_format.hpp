@@ -0,0 +1,82 @@
+#ifndef KENGINE_CORE_LOG_FORMAT_HPP
+#define KENGINE_CORE_LOG_FORMAT_HPP
+
+#include <kengine/types.hpp>
+
+#include <array>
+
+namespace kengine::core {
+
+// a run of literal text in a format string, between two placeholders
+struct LogFormatSegment {
+	kengine::u16 offset;
+	kengine::u16 length;
+};
+
+// a format string split at its placeholders: segments[i] is written before argument i, the last one after all of them
+struct LogFormatInfo {
+	char const* string;
+	kengine::usize argumentCount;
+	LogFormatSegment const* segments;
+};
+
+namespace detail {
+
+constexpr kengine::usize countPlaceholders(char const* format) {
+	kengine::usize count = 0;
+	for (kengine::usize i = 0; format[i] != '\0'; ++i) {
+		if (format[i] == '{' && format[i + 1] == '}') {
+			++count;
+			++i;
+		}
+	}
+
+	return count;
+}
+
+template<kengine::usize Count>
+constexpr std::array<LogFormatSegment, Count> parseSegments(char const* format) {
+	std::array<LogFormatSegment, Count> segments = {};
+
+	kengine::usize segment = 0;
+	kengine::usize start = 0;
+	kengine::usize i = 0;
+	for (; format[i] != '\0'; ++i) {
+		if (format[i] == '{' && format[i + 1] == '}') {
+			segments[segment++] = { static_cast<kengine::u16>(start), static_cast<kengine::u16>(i - start) };
+			start = i + 2;
+			++i;
+		}
+	}
+
+	segments[segment] = { static_cast<kengine::u16>(start), static_cast<kengine::u16>(i - start) };
+	return segments;
+}
+
+} // namespace detail
+
+// parsed at compile time, Source::value() returns the string literal; build one with KENGINE_FMT
+template<typename Source>
+struct LogFormat {
+	static constexpr char const* string = Source::value();
+	static constexpr kengine::usize argumentCount = detail::countPlaceholders(string);
+	static constexpr std::array<LogFormatSegment, argumentCount + 1> segments = detail::parseSegments<argumentCount + 1>(string);
+	static constexpr LogFormatInfo info = { string, argumentCount, segments.data() };
+};
+
+template<typename Source>
+constexpr LogFormat<Source> makeLogFormat(Source) {
+	return {};
+}
+
+} // namespace kengine::core
+
+// the local struct gives every call site its own type, which carries the literal into a constant expression
+#define KENGINE_FMT(format) ::kengine::core::makeLogFormat([] { \
+	struct Source { \
+		static constexpr char const* value() { return format; } \
+	}; \
+	return Source{}; \
+}())
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef KENGINE_CORE_LOG_LIMITER_HPP
+#define KENGINE_CORE_LOG_LIMITER_HPP
+
+#include <kengine/types.hpp>
+
+#include <atomic>
+
+namespace kengine::core {
+
+// Per call site state for KENGINE_LOG_LIMITED: folds a message that repeats the last one shown into a count and caps how
+// many distinct messages get through per window. Every thread goes through the same atomics, the counts are best effort.
+class LogLimiter {
+public:
+	LogLimiter(kengine::u32 maxPerWindow = 10, kengine::f64 windowSeconds = 1.0)
+		: _maxPerWindow(maxPerWindow), _window(static_cast<kengine::u64>(windowSeconds * 1e9)) {}
+
+	// false once the call site is over its rate, suppressed gets what was dropped in the window that just ended
+	bool admit(kengine::u64 now, kengine::u32& suppressed) {
+		suppressed = 0;
+
+		kengine::u64 start = _windowStart.load(std::memory_order_relaxed);
+		if (now - start >= _window && _windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+			suppressed = _suppressed.exchange(0, std::memory_order_relaxed);
+			_count.store(0, std::memory_order_relaxed);
+		}
+
+		if (_count.fetch_add(1, std::memory_order_relaxed) < _maxPerWindow) {
+			return true;
+		}
+
+		_suppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	// true when the message hashes like the last one shown and the window since has not passed, the repeat is only
+	// counted, it never reaches admit so it does not use up the rate
+	bool isRepeat(kengine::u64 hash, kengine::u64 now) {
+		if (_lastHash.load(std::memory_order_relaxed) == hash && now - _lastShown.load(std::memory_order_relaxed) < _window) {
+			_repeats.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		return false;
+	}
+
+	// records an admitted message as the last one shown, repeats gets how often the previous one came again
+	void markShown(kengine::u64 hash, kengine::u64 now, kengine::u32& repeats) {
+		_lastHash.store(hash, std::memory_order_relaxed);
+		_lastShown.store(now, std::memory_order_relaxed);
+		repeats = _repeats.exchange(0, std::memory_order_relaxed);
+	}
+
+private:
+	kengine::u32 _maxPerWindow;
+	kengine::u64 _window;
+
+	std::atomic<kengine::u64> _windowStart = 0;
+	std::atomic<kengine::u32> _count = 0;
+	std::atomic<kengine::u32> _suppressed = 0;
+
+	std::atomic<kengine::u64> _lastHash = 0;
+	std::atomic<kengine::u64> _lastShown = 0;
+	std::atomic<kengine::u32> _repeats = 0;
+};
+
+} // namespace kengine::core
+
+#endif
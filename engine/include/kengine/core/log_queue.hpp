@@ -0,0 +1,218 @@
+#ifndef KENGINE_CORE_LOG_QUEUE_HPP
+#define KENGINE_CORE_LOG_QUEUE_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/core/uuid.hpp>
+#include <kengine/core/log_format.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace kengine::core {
+
+enum class LogSeverity {
+	Trace = -3,
+	Verbose = -2,
+	Debug = -1,
+	Info = 0,
+	Warning = 1,
+	Error = 2,
+	Fatal = 3,
+};
+
+enum class LogArgumentType : kengine::u8 {
+	Bool,
+	Char,
+	Signed,
+	Unsigned,
+	Float,
+	Pointer,
+	UUID,
+	String,
+};
+
+// header of a packed log record, the arguments follow it as a type tag and a raw value each
+struct LogRecord {
+	// bytes including the header, a multiple of 8
+	kengine::u32 size;
+	LogSeverity severity;
+
+	// must outlive the record, only string literals are passed here
+	char const* format;
+
+	// set when the format was parsed at compile time, then nothing scans the string again
+	LogFormatInfo const* layout;
+	kengine::u64 time;
+};
+
+// packs arguments after a LogRecord header into a caller-provided buffer, strings are truncated when it runs out
+class LogRecordWriter {
+public:
+	static constexpr kengine::usize maxRecordSize = 4096;
+
+	LogRecordWriter(kengine::u8* buffer, LogSeverity severity, char const* format, kengine::usize capacity = maxRecordSize) : _buffer(buffer), _size(sizeof(LogRecord)), _capacity(capacity) {
+		LogRecord record = { 0, severity, format, nullptr, 0 };
+		std::memcpy(_buffer, &record, sizeof(LogRecord));
+	}
+
+	LogRecordWriter(kengine::u8* buffer, LogSeverity severity, LogFormatInfo const& format, kengine::usize capacity = maxRecordSize) : _buffer(buffer), _size(sizeof(LogRecord)), _capacity(capacity) {
+		LogRecord record = { 0, severity, format.string, &format, 0 };
+		std::memcpy(_buffer, &record, sizeof(LogRecord));
+	}
+
+	template<typename T>
+	void put(T const& value) {
+		if constexpr (std::is_same_v<T, bool>) {
+			_putValue(LogArgumentType::Bool, static_cast<kengine::u8>(value));
+		} else if constexpr (std::is_same_v<T, char>) {
+			_putValue(LogArgumentType::Char, value);
+		} else if constexpr (std::is_enum_v<T>) {
+			put(static_cast<std::underlying_type_t<T>>(value));
+		} else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+			_putValue(LogArgumentType::Signed, static_cast<kengine::s64>(value));
+		} else if constexpr (std::is_integral_v<T>) {
+			_putValue(LogArgumentType::Unsigned, static_cast<kengine::u64>(value));
+		} else if constexpr (std::is_floating_point_v<T>) {
+			_putValue(LogArgumentType::Float, static_cast<kengine::f64>(value));
+		} else if constexpr (std::is_convertible_v<T const&, std::string_view>) {
+			putString(std::string_view(value));
+		} else if constexpr (std::is_same_v<T, UUID>) {
+			_putValue(LogArgumentType::UUID, value.getUUID());
+		} else if constexpr (std::is_pointer_v<T>) {
+			_putValue(LogArgumentType::Pointer, static_cast<kengine::u64>(reinterpret_cast<std::uintptr_t>(value)));
+		} else {
+			// anything else only has operator<<, so it gets formatted here instead of on the logging thread
+			std::ostringstream stream;
+			stream << value;
+			putString(stream.str());
+		}
+	}
+
+	void putString(std::string_view value) {
+		if (_size + 3 > _capacity) {
+			return;
+		}
+
+		kengine::u16 length = static_cast<kengine::u16>(std::min(value.size(), _capacity - _size - 3));
+		_buffer[_size] = static_cast<kengine::u8>(LogArgumentType::String);
+		std::memcpy(_buffer + _size + 1, &length, sizeof(length));
+		std::memcpy(_buffer + _size + 3, value.data(), length);
+		_size += 3 + length;
+	}
+
+	kengine::usize getSize() const { return _size; }
+
+	// finishes the header and returns the record size, the padding is filled with an invalid argument tag
+	kengine::u32 finish(kengine::u64 time) {
+		kengine::u32 size = static_cast<kengine::u32>((_size + 7) & ~static_cast<kengine::usize>(7));
+		std::memset(_buffer + _size, 0xFF, size - _size);
+		std::memcpy(_buffer + offsetof(LogRecord, size), &size, sizeof(size));
+		std::memcpy(_buffer + offsetof(LogRecord, time), &time, sizeof(time));
+		return size;
+	}
+
+private:
+	template<typename T>
+	void _putValue(LogArgumentType type, T value) {
+		if (_size + 1 + sizeof(T) > _capacity) {
+			return;
+		}
+
+		_buffer[_size] = static_cast<kengine::u8>(type);
+		std::memcpy(_buffer + _size + 1, &value, sizeof(T));
+		_size += 1 + sizeof(T);
+	}
+
+	kengine::u8* _buffer;
+	kengine::usize _size;
+	kengine::usize _capacity;
+};
+
+// steady clock nanoseconds, the time stamped on every record
+kengine::u64 logTimestamp();
+
+// appends a record's format with its arguments substituted for each {}
+void formatLogRecord(std::string& out, kengine::u8 const* record);
+
+// single producer single consumer ring of variable-sized records, one per logging thread
+class LogQueue {
+public:
+	static constexpr kengine::usize capacity = 1 << 16;
+
+	// producer only, false when there is no room
+	bool push(kengine::u8 const* record, kengine::u32 size) {
+		kengine::u64 head = _head.load(std::memory_order_relaxed);
+		kengine::usize skip = _skip(head, size);
+
+		if (head + skip + size - _cachedTail > capacity) {
+			_cachedTail = _tail.load(std::memory_order_acquire);
+			if (head + skip + size - _cachedTail > capacity) {
+				return false;
+			}
+		}
+
+		// a record never wraps, the end of the buffer is marked as padding instead
+		if (skip >= sizeof(LogRecord)) {
+			LogRecord padding = { static_cast<kengine::u32>(skip), LogSeverity::Info, nullptr, nullptr, 0 };
+			std::memcpy(_buffer + (head & (capacity - 1)), &padding, sizeof(LogRecord));
+		}
+
+		std::memcpy(_buffer + ((head + skip) & (capacity - 1)), record, size);
+		_head.store(head + skip + size, std::memory_order_release);
+		return true;
+	}
+
+	// consumer only, calls fn(record) for everything pushed so far and returns the position to release once
+	// the records have been handled, their memory stays valid until then
+	template<typename F>
+	kengine::u64 consume(F&& fn) {
+		kengine::u64 tail = _tail.load(std::memory_order_relaxed);
+		kengine::u64 head = _head.load(std::memory_order_acquire);
+
+		while (tail < head) {
+			kengine::usize offset = static_cast<kengine::usize>(tail & (capacity - 1));
+			if (capacity - offset < sizeof(LogRecord)) {
+				tail += capacity - offset;
+				continue;
+			}
+
+			LogRecord record;
+			std::memcpy(&record, _buffer + offset, sizeof(LogRecord));
+			if (record.format != nullptr) {
+				fn(_buffer + offset);
+			}
+
+			tail += record.size;
+		}
+
+		return tail;
+	}
+
+	// consumer only, hands the space up to tail back to the producer
+	void release(kengine::u64 tail) { _tail.store(tail, std::memory_order_release); }
+
+	kengine::u64 getHead() const { return _head.load(std::memory_order_acquire); }
+	kengine::u64 getTail() const { return _tail.load(std::memory_order_acquire); }
+
+private:
+	// bytes left before the end of the buffer when the record does not fit in them
+	static kengine::usize _skip(kengine::u64 head, kengine::u32 size) {
+		kengine::usize remaining = capacity - static_cast<kengine::usize>(head & (capacity - 1));
+		return remaining < size ? remaining : 0;
+	}
+
+	alignas(64) std::atomic<kengine::u64> _head = 0;
+	kengine::u64 _cachedTail = 0;
+	alignas(64) std::atomic<kengine::u64> _tail = 0;
+	alignas(64) kengine::u8 _buffer[capacity];
+};
+
+} // namespace kengine::core
+
+#endif
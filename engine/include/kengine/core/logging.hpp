@@ -5,26 +5,52 @@
 #include <cstdio>
 #include <string>
 #include <sstream>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <kengine/types.hpp>
 #include <kengine/singleton.hpp>
 #include <kengine/core/uuid.hpp>
+#include <kengine/core/log_queue.hpp>
+#include <kengine/core/log_limiter.hpp>
+#include <kengine/util/hash.hpp>
 
 namespace kengine::core {
 
-enum class LogSeverity {
-	Trace = -3,
-	Verbose = -2,
-	Debug = -1,
-	Info = 0,
-	Warning = 1,
-	Error = 2,
-	Fatal = 3,
+// subsystems that get their own log level
+enum class LogCategory : kengine::u8 {
+	General,
+	Core,
+	Platform,
+	Memory,
+	Jobs,
+	Graphics,
+	Assets,
+	Events,
+	Count,
 };
 
+#ifndef KENGINE_LOG_MIN_SEVERITY
+#define KENGINE_LOG_MIN_SEVERITY Trace
+#endif
+
+// anything below this never reaches the logger, KENGINE_LOG leaves no code behind for it
+constexpr LogSeverity minimumLogSeverity = LogSeverity::KENGINE_LOG_MIN_SEVERITY;
+
 class ILogger {
 public:
 	virtual void log(LogSeverity severity, std::string const& message) = 0;
+
+	// writes out whatever log() buffered, the async logger calls this once per batch
+	virtual void flush() {}
+
+	// sinks that store packed records as they are return true, the logger then skips formatting for them
+	virtual bool logRecord(kengine::u8 const*) { return false; }
+
 	virtual ~ILogger() = default;
 
 	void severityAsString(LogSeverity severity, std::string& string) {
@@ -60,59 +86,15 @@ public:
 	}
 
 	template<typename... Args>
-	void logf(LogSeverity severity, std::string const& format, Args... args) {
-		std::stringstream s;
-		logfConcat(s, format, args...);
-
-		log(severity, s.str());
-	}
-
-private:
-	template<typename T>
-	std::stringstream& logfValue(std::stringstream& sstream, T const& value) {
-		sstream << value;
-		return sstream;
-	}
-
-	std::stringstream& logfValue(std::stringstream& sstream, bool const& value) {
-		sstream << (value ? "true" : "false");
-		return sstream;
-	}
-
-	std::stringstream& logfValue(std::stringstream& sstream, UUID const& value) {
-		sstream << value.toString();
-		return sstream;
-	}
-
-	template<typename T>
-	kengine::usize logfConcat(std::stringstream& sstream, std::string const& format, T const& value) {
-		kengine::usize index = format.find("{}");
-		if (index == std::string::npos) {
-			sstream << format;
-			return 0;
-		}
-
-		sstream << format.substr(0, index);
-		logfValue(sstream, value) << format.substr(index + 2);
-		return std::string::npos;
-	}
-
-	template<typename T, typename... Args>
-	kengine::usize logfConcat(std::stringstream& sstream, std::string const& format, T const& value, Args const&... args) {
-		kengine::usize index = format.find("{}");
-		if (index == std::string::npos) {
-			sstream << format;
-			return 0;
-		}
-
-		sstream << format.substr(0, index);
-		logfValue(sstream, value);
-
-		if (index + 2 < format.size()) {
-			return logfConcat(sstream, format.substr(index + 2), args...);
-		}
-
-		return index;
+	void logf(LogSeverity severity, std::string const& format, Args const&... args) {
+		kengine::u8 buffer[LogRecordWriter::maxRecordSize];
+		LogRecordWriter writer(buffer, severity, format.c_str());
+		(writer.put(args), ...);
+		writer.finish(0);
+
+		std::string message;
+		formatLogRecord(message, buffer);
+		log(severity, message);
 	}
 };
 
@@ -123,9 +105,11 @@ public:
 	void log(LogSeverity severity, std::string const& message) override {
 		std::string sev;
 		severityAsString(severity, sev);
-		stream << "[" << sev << "] " << message << std::endl;
+		stream << "[" << sev << "] " << message << '\n';
 	}
 
+	void flush() override { stream.flush(); }
+
 private:
 	std::ostream& stream;
 };
@@ -140,12 +124,20 @@ public:
 		std::fprintf(file, "[%s] %s\n", sev.c_str(), message.c_str());
 	}
 
+	void flush() override { std::fflush(file); }
+
 private:
 	FILE* file;
 };
 
+// Callers pack the format pointer and their arguments into a record. Once start() has been called the
+// record goes into a per-thread queue and a background thread formats and writes it in batches,
+// otherwise it is formatted and written right away
 class Logger : public kengine::Singleton<Logger> {
 public:
+	Logger() { setLevel(LogSeverity::Info); }
+	~Logger();
+
 	void init() {
 		if (logger != nullptr) {
 			throw std::runtime_error("Logger already initialized");
@@ -178,39 +170,196 @@ public:
 		logger = new StreamLogger(s);
 	}
 
-	void deinit() { delete logger; }
+	void deinit() {
+		stop();
+		delete logger;
+		logger = nullptr;
+	}
+
+	// starts the background thread, from then on logging only costs the caller a copy into its queue
+	void start();
+
+	// writes out everything queued and goes back to logging synchronously
+	void stop();
+
+	bool isAsync() const { return _running.load(std::memory_order_acquire); }
+
+	// blocks until every record queued before the call has been written
+	void flush();
+
+	void setLevel(LogSeverity level) {
+		for (std::atomic<LogSeverity>& categoryLevel : _levels) {
+			categoryLevel.store(level, std::memory_order_relaxed);
+		}
+	}
+
+	void setLevel(LogCategory category, LogSeverity level) { _levels[static_cast<kengine::usize>(category)].store(level, std::memory_order_relaxed); }
+	LogSeverity getLevel(LogCategory category) const { return _levels[static_cast<kengine::usize>(category)].load(std::memory_order_relaxed); }
+
+	bool isEnabled(LogCategory category, LogSeverity severity) const {
+		return severity >= minimumLogSeverity && severity >= getLevel(category);
+	}
 
 	void log(LogSeverity severity, std::string const& message) {
-		if (logger == nullptr) {
-			logger = new StreamLogger(std::cout);
+		logf(severity, "{}", message);
+	}
+
+	// format has to be a string literal, the logging thread reads it after the call returns
+	template<kengine::usize N, typename... Args>
+	void logf(LogSeverity severity, char const (&format)[N], Args const&... args) {
+		if (isEnabled(LogCategory::General, severity)) {
+			_pack(severity, static_cast<char const*>(format), args...);
 		}
+	}
 
-		logger->log(severity, message);
+	// format comes from KENGINE_FMT, its placeholders are counted against the arguments at compile time
+	template<typename Source, typename... Args>
+	void logf(LogSeverity severity, LogFormat<Source> format, Args const&... args) {
+		logf(LogCategory::General, severity, format, args...);
 	}
 
-	void logf(LogSeverity severity, std::string const& format) {
-		if (logger == nullptr) {
-			logger = new StreamLogger(std::cout);
+	template<typename Source, typename... Args>
+	void logf(LogCategory category, LogSeverity severity, LogFormat<Source>, Args const&... args) {
+		static_assert(sizeof...(Args) == LogFormat<Source>::argumentCount, "Log format placeholder count does not match the number of arguments");
+
+		if (isEnabled(category, severity)) {
+			_pack(severity, LogFormat<Source>::info, args...);
 		}
+	}
 
-		logger->logf(severity, format);
+	// queues a record that was packed and finished elsewhere, an Exception for one
+	void submit(kengine::u8 const* record) {
+		LogRecord header;
+		std::memcpy(&header, record, sizeof(LogRecord));
+
+		if (isEnabled(LogCategory::General, header.severity)) {
+			_submit(header.severity, record, header.size);
+		}
 	}
 
+	// the KENGINE_LOG_LIMITED path: the limiter drops what is over the call site's rate or repeats the last message,
+	// and what it dropped is reported as a summary line once the call site logs again
+	template<typename Source, typename... Args>
+	void logf(LogLimiter& limiter, LogCategory category, LogSeverity severity, LogFormat<Source>, Args const&... args) {
+		static_assert(sizeof...(Args) == LogFormat<Source>::argumentCount, "Log format placeholder count does not match the number of arguments");
+
+		if (!isEnabled(category, severity)) {
+			return;
+		}
+
+		kengine::u8 buffer[LogRecordWriter::maxRecordSize];
+		LogRecordWriter writer(buffer, severity, LogFormat<Source>::info);
+		(writer.put(args), ...);
+
+		// repeats are folded before the rate is checked, so they are neither counted against it nor reported as dropped
+		kengine::u64 now = logTimestamp();
+		kengine::u64 hash = util::hash(reinterpret_cast<char const*>(buffer) + sizeof(LogRecord), writer.getSize() - sizeof(LogRecord));
+		if (limiter.isRepeat(hash, now)) {
+			return;
+		}
+
+		kengine::u32 suppressed;
+		bool admitted = limiter.admit(now, suppressed);
+		if (suppressed > 0) {
+			_pack(severity, "Rate limited: {} more \"{}\" messages were dropped", suppressed, LogFormat<Source>::string);
+		}
+
+		if (!admitted) {
+			return;
+		}
+
+		kengine::u32 repeats;
+		limiter.markShown(hash, now, repeats);
+		if (repeats > 0) {
+			_pack(severity, "Previous \"{}\" message repeated {} more times", LogFormat<Source>::string, repeats);
+		}
+
+		_submit(severity, buffer, writer.finish(logTimestamp()));
+	}
+
+	// formats built at runtime are resolved here, only the result is queued
 	template<typename... Args>
-	void logf(LogSeverity severity, std::string const& format, Args... args) {
-		if (logger == nullptr) {
-			logger = new StreamLogger(std::cout);
+	void logf(LogSeverity severity, std::string const& format, Args const&... args) {
+		if (!isEnabled(LogCategory::General, severity)) {
+			return;
 		}
 
-		logger->logf(severity, format, args...);
+		kengine::u8 buffer[LogRecordWriter::maxRecordSize];
+		LogRecordWriter writer(buffer, severity, format.c_str());
+		(writer.put(args), ...);
+		writer.finish(0);
+
+		std::string message;
+		formatLogRecord(message, buffer);
+		log(severity, message);
 	}
 
 	ILogger* getLogger() { return logger; }
 
 private:
-	ILogger* logger;
+	template<typename Format, typename... Args>
+	void _pack(LogSeverity severity, Format const& format, Args const&... args) {
+		kengine::u8 buffer[LogRecordWriter::maxRecordSize];
+		LogRecordWriter writer(buffer, severity, format);
+		(writer.put(args), ...);
+		_submit(severity, buffer, writer.finish(logTimestamp()));
+	}
+
+	void _submit(LogSeverity severity, kengine::u8 const* record, kengine::u32 size);
+	void _write(kengine::u8 const* record, std::string& line);
+	void _run();
+	kengine::usize _drain();
+
+	LogQueue& _threadQueue();
+
+	ILogger* logger = nullptr;
+
+	std::atomic<LogSeverity> _levels[static_cast<kengine::usize>(LogCategory::Count)];
+
+	std::atomic<bool> _running = false;
+	std::thread _thread;
+
+	// submits that saw the logger running and may not have pushed yet
+	std::atomic<kengine::u32> _submitting = 0;
+
+	std::mutex _wakeMutex;
+	std::condition_variable _wake;
+
+	std::mutex _queuesMutex;
+	std::vector<std::unique_ptr<LogQueue>> _queues;
+
+	// held around every write to logger, before start() and after stop() any thread may write to it directly
+	std::mutex _sinkMutex;
+
+	// consumer only, records of one batch sorted by time before they are written
+	std::vector<kengine::u8> _batch;
+	std::vector<kengine::usize> _batchRecords;
+	std::vector<std::pair<LogQueue*, kengine::u64>> _consumed;
+	std::string _line;
 };
 
 } // namespace kengine::core
 
+// Checks the category's level before the arguments are evaluated, so a disabled call costs one relaxed load,
+// and one below KENGINE_LOG_MIN_SEVERITY costs nothing. The format is checked like KENGINE_FMT.
+#define KENGINE_LOG(category, severity, format, ...) \
+	do { \
+		if constexpr (::kengine::core::LogSeverity::severity >= ::kengine::core::minimumLogSeverity) { \
+			if (::kengine::core::Logger::get().isEnabled(::kengine::core::LogCategory::category, ::kengine::core::LogSeverity::severity)) { \
+				::kengine::core::Logger::get().logf(::kengine::core::LogCategory::category, ::kengine::core::LogSeverity::severity, KENGINE_FMT(format), ##__VA_ARGS__); \
+			} \
+		} \
+	} while (false)
+
+// KENGINE_LOG for call sites that can fire every frame, see Logger::logf(LogLimiter&, ...)
+#define KENGINE_LOG_LIMITED(category, severity, format, ...) \
+	do { \
+		if constexpr (::kengine::core::LogSeverity::severity >= ::kengine::core::minimumLogSeverity) { \
+			static ::kengine::core::LogLimiter _kengineLogLimiter; \
+			if (::kengine::core::Logger::get().isEnabled(::kengine::core::LogCategory::category, ::kengine::core::LogSeverity::severity)) { \
+				::kengine::core::Logger::get().logf(_kengineLogLimiter, ::kengine::core::LogCategory::category, ::kengine::core::LogSeverity::severity, KENGINE_FMT(format), ##__VA_ARGS__); \
+			} \
+		} \
+	} while (false)
+
 #endif
@@ -3,10 +3,12 @@
 
 #include <kengine/types.hpp>
 #include <kengine/core/logging.hpp>
+#include <kengine/core/expected.hpp>
 #include <kengine/singleton.hpp>
 
 #include <unordered_map>
 #include <functional>
+#include <vector>
 
 namespace kengine::core::platform {
 
@@ -42,34 +44,9 @@ struct IMemoryType {
 	}
 };
 
+// defined after Memory, its dealloc calls back into it
 template<typename T>
-struct UUIDMemoryType : public IMemoryType {
-	bool array = false;
-
-	void dealloc(void* ptr) override {
-		if (array) {
-			Memory::get().deallocArray<T>(static_cast<T*>(ptr));
-		} else {
-			Memory::get().dealloc<T>(static_cast<T*>(ptr));
-		}
-	}
-
-	UUIDMemoryType() {
-		size = sizeof(T);
-	}
-
-	UUIDMemoryType(bool arr) {
-		size = sizeof(T);
-		array = arr;
-	}
-
-	const UUID& getUUID() const override { return getUUIDStatic(); }
-
-	static const UUID& getUUIDStatic() {
-		static UUID uuid = UUID();
-		return uuid;
-	}
-};
+struct UUIDMemoryType;
 
 class Memory : public Singleton<Memory> {
 public:
@@ -95,35 +72,48 @@ public:
 		return ptr;
 	}
 
+	// throws on misuse, see tryDealloc for the variant that reports it instead
 	template<typename T>
 	void dealloc(T* ptr) {
+		Status status = tryDealloc(ptr);
+		if (status.error().code == ErrorCode::TypeMismatch) {
+			throw kengine::core::Exception("Memory::dealloc<T>: Trying to deallocate pointer with type index not matching templated type (allocated UUID {}, passed UUID {}), could be freeing the wrong allocation", _memoryTypes[_allocations[ptr].typeIndex]->getUUID().toString(), UUIDMemoryType<T>::getUUIDStatic().toString());
+		}
+
+		status.check();
+	}
+
+	template<typename T>
+	Status tryDealloc(T* ptr) {
 		if (ptr == nullptr) {
-			throw kengine::core::Exception("Memory::dealloc<T>: Trying to deallocate null pointer");
+			return Error{ ErrorCode::InvalidArgument, "Memory::dealloc<T>: Trying to deallocate null pointer" };
 		}
 
-		if (_allocations.find(ptr) == _allocations.end()) {
-			throw kengine::core::Exception("Memory::dealloc<T>: Trying to deallocate untracked pointer, could be a double-free or a garbage pointer");
+		auto allocation = _allocations.find(ptr);
+		if (allocation == _allocations.end()) {
+			return Error{ ErrorCode::NotFound, "Memory::dealloc<T>: Trying to deallocate untracked pointer, could be a double-free or a garbage pointer" };
 		}
 
-		if (!_allocations[ptr].typed) {
-			throw kengine::core::Exception("Memory::dealloc<T>: Trying to deallocate pointer not template typed, therefore not allocated by Memory::alloc<T>, try using Memory::dealloc or Memory::deallocAligned instead");
+		AllocationEntry const& entry = allocation->second;
+		if (!entry.typed) {
+			return Error{ ErrorCode::InvalidArgument, "Memory::dealloc<T>: Trying to deallocate pointer not template typed, therefore not allocated by Memory::alloc<T>, try using Memory::dealloc or Memory::deallocAligned instead" };
 		}
 
-		if (_allocations[ptr].array) {
-			throw kengine::core::Exception("Memory::dealloc<T>: Trying to deallocate pointer allocated by Memory::allocArray<T>, try using Memory::deallocArray<T>");
+		if (entry.array) {
+			return Error{ ErrorCode::InvalidArgument, "Memory::dealloc<T>: Trying to deallocate pointer allocated by Memory::allocArray<T>, try using Memory::deallocArray<T>" };
 		}
 
-		if (_allocations[ptr].aligned) {
-			throw kengine::core::Exception("Memory::dealloc<T>: Trying to deallocate pointer allocated by Memory::allocAligned, try using Memory::deallocAligned instead");
+		if (entry.aligned) {
+			return Error{ ErrorCode::InvalidArgument, "Memory::dealloc<T>: Trying to deallocate pointer allocated by Memory::allocAligned, try using Memory::deallocAligned instead" };
 		}
-		
-		UUIDMemoryType<T> type;
-		if (_memoryTypes[_allocations[ptr].typeIndex]->getUUID() != type.getUUID()) {
-			throw kengine::core::Exception("Memory::dealloc<T>: Trying to deallocate pointer with type index not matching templated type (allocated UUID {}, passed UUID {}), could be freeing the wrong allocation", _memoryTypes[_allocations[ptr].typeIndex]->getUUID().toString(), type.getUUID().toString());
+
+		if (_memoryTypes[entry.typeIndex]->getUUID() != UUIDMemoryType<T>::getUUIDStatic()) {
+			return Error{ ErrorCode::TypeMismatch, "Memory::dealloc<T>: Trying to deallocate pointer with type index not matching templated type, could be freeing the wrong allocation" };
 		}
 
 		delete ptr;
 		unmarkAllocation(ptr);
+		return {};
 	}
 
 	template<typename T>
@@ -146,35 +136,48 @@ public:
 		return ptr;
 	}
 
+	// throws on misuse, see tryDeallocArray for the variant that reports it instead
 	template<typename T>
 	void deallocArray(T* ptr) {
+		Status status = tryDeallocArray(ptr);
+		if (status.error().code == ErrorCode::TypeMismatch) {
+			throw kengine::core::Exception("Memory::deallocArray<T>: Trying to deallocate pointer with type index not matching templated type (allocated UUID {}, passed UUID {}), could be freeing the wrong allocation", _memoryTypes[_allocations[ptr].typeIndex]->getUUID().toString(), UUIDMemoryType<T>::getUUIDStatic().toString());
+		}
+
+		status.check();
+	}
+
+	template<typename T>
+	Status tryDeallocArray(T* ptr) {
 		if (ptr == nullptr) {
-			throw kengine::core::Exception("Memory::deallocArray<T>: Trying to deallocate null pointer");
+			return Error{ ErrorCode::InvalidArgument, "Memory::deallocArray<T>: Trying to deallocate null pointer" };
 		}
 
-		if (_allocations.find(ptr) == _allocations.end()) {
-			throw kengine::core::Exception("Memory::deallocArray<T>: Trying to deallocate untracked pointer, could be a double-free or a garbage pointer");
+		auto allocation = _allocations.find(ptr);
+		if (allocation == _allocations.end()) {
+			return Error{ ErrorCode::NotFound, "Memory::deallocArray<T>: Trying to deallocate untracked pointer, could be a double-free or a garbage pointer" };
 		}
 
-		if (!_allocations[ptr].typed) {
-			throw kengine::core::Exception("Memory::deallocArray<T>: Trying to deallocate pointer not template typed, therefore not allocated by Memory::allocArray<T>, try using Memory::alloc or Memory::allocAligned instead");
+		AllocationEntry const& entry = allocation->second;
+		if (!entry.typed) {
+			return Error{ ErrorCode::InvalidArgument, "Memory::deallocArray<T>: Trying to deallocate pointer not template typed, therefore not allocated by Memory::allocArray<T>, try using Memory::alloc or Memory::allocAligned instead" };
 		}
 
-		if (!_allocations[ptr].array) {
-			throw kengine::core::Exception("Memory::deallocArray<T>: Trying to deallocate pointer allocated by Memory::alloc<T>, try using Memory::dealloc<T>");
+		if (!entry.array) {
+			return Error{ ErrorCode::InvalidArgument, "Memory::deallocArray<T>: Trying to deallocate pointer allocated by Memory::alloc<T>, try using Memory::dealloc<T>" };
 		}
 
-		if (_allocations[ptr].aligned) {
-			throw kengine::core::Exception("Memory::deallocArray<T>: Trying to deallocate pointer allocated by Memory::allocAligned, try using Memory::deallocAligned instead");
+		if (entry.aligned) {
+			return Error{ ErrorCode::InvalidArgument, "Memory::deallocArray<T>: Trying to deallocate pointer allocated by Memory::allocAligned, try using Memory::deallocAligned instead" };
 		}
-		
-		UUIDMemoryType<T> type;
-		if (_memoryTypes[_allocations[ptr].typeIndex]->getUUID() != type.getUUID()) {
-			throw kengine::core::Exception("Memory::deallocArray<T>: Trying to deallocate pointer with type index not matching templated type (allocated UUID {}, passed UUID {}), could be freeing the wrong allocation", _memoryTypes[_allocations[ptr].typeIndex]->getUUID().toString(), type.getUUID().toString());
+
+		if (_memoryTypes[entry.typeIndex]->getUUID() != UUIDMemoryType<T>::getUUIDStatic()) {
+			return Error{ ErrorCode::TypeMismatch, "Memory::deallocArray<T>: Trying to deallocate pointer with type index not matching templated type, could be freeing the wrong allocation" };
 		}
 
 		delete[] ptr;
 		unmarkAllocation(ptr);
+		return {};
 	}
 
 	void* alloc(kengine::u64 size, AllocationTag tag);
@@ -214,6 +217,35 @@ private:
 	std::vector<IMemoryType*> _memoryTypes;
 };
 
+template<typename T>
+struct UUIDMemoryType : public IMemoryType {
+	bool array = false;
+
+	void dealloc(void* ptr) override {
+		if (array) {
+			Memory::get().deallocArray<T>(static_cast<T*>(ptr));
+		} else {
+			Memory::get().dealloc<T>(static_cast<T*>(ptr));
+		}
+	}
+
+	UUIDMemoryType() {
+		size = sizeof(T);
+	}
+
+	UUIDMemoryType(bool arr) {
+		size = sizeof(T);
+		array = arr;
+	}
+
+	const UUID& getUUID() const override { return getUUIDStatic(); }
+
+	static const UUID& getUUIDStatic() {
+		static UUID uuid = UUID();
+		return uuid;
+	}
+};
+
 } // namespace kengine::core::platform
 
 #endif
\ No newline at end of file
@@ -12,7 +12,12 @@ public:
 	virtual void shutdown() = 0;
 	virtual bool update() = 0;
 
+	// monotonic seconds since init
 	virtual kengine::f64 getTime() = 0;
+
+	// blocks for about the given time, may wake late by the OS scheduler granularity
+	virtual void sleep(kengine::f64 seconds) = 0;
+
 	virtual ~IPlatform() = default;
 
 protected:
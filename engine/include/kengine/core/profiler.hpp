@@ -0,0 +1,141 @@
+#ifndef KENGINE_CORE_PROFILER_HPP
+#define KENGINE_CORE_PROFILER_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/macros.hpp>
+#include <kengine/singleton.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(KENGINE_SIMD_SSE2)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define KENGINE_PROFILER_RDTSC
+#endif
+
+namespace kengine::core {
+
+enum class ProfileEventType : kengine::u8 {
+	Zone = 0,
+	Frame = 1,
+};
+
+// name always points at a string literal, so recording never copies or allocates
+struct ProfileEvent {
+	char const* name;
+	kengine::u64 start;
+	kengine::u64 end;
+	kengine::u16 depth;
+	ProfileEventType type;
+};
+
+// raw timestamps in ticks, rdtsc where available
+inline kengine::u64 profilerTicks() {
+#ifdef KENGINE_PROFILER_RDTSC
+	return __rdtsc();
+#else
+	return static_cast<kengine::u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+class Profiler : public Singleton<Profiler> {
+public:
+	// events kept per thread, older ones are overwritten
+	static constexpr kengine::usize ringCapacity = 1 << 15;
+
+	Profiler();
+
+	void setEnabled(bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+	bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+	void record(char const* name, kengine::u64 start, kengine::u64 end, kengine::u16 depth, ProfileEventType type = ProfileEventType::Zone);
+
+	// marks the start of a frame on the calling thread
+	void frame();
+
+	// both exports snapshot every thread's ring; neither stops recording
+	bool exportChromeTrace(std::string const& path);
+
+	// "KPRF" v1: header, name table, then fixed-size event records, see profiler.cpp for the layout
+	bool exportBinary(std::string const& path);
+
+	kengine::f64 getTicksPerSecond();
+
+private:
+	struct ThreadRing {
+		alignas(64) std::atomic<kengine::u64> head = 0;
+		kengine::u32 thread = 0;
+		ProfileEvent events[ringCapacity];
+	};
+
+	struct ThreadEvent {
+		ProfileEvent event;
+		kengine::u32 thread;
+	};
+
+	ThreadRing& _threadRing();
+	std::vector<ThreadEvent> _snapshot();
+
+	std::atomic<bool> _enabled = true;
+
+	kengine::u64 _calibrationTicks;
+	kengine::s64 _calibrationNanoseconds;
+
+	std::mutex _ringsMutex;
+	std::vector<std::unique_ptr<ThreadRing>> _rings;
+};
+
+// times its own scope, nested zones get increasing depth
+class ProfileZone {
+public:
+	ProfileZone(char const* name) : _name(name) {
+		if (Profiler::get().isEnabled()) {
+			_depth = _currentDepth++;
+			_start = profilerTicks();
+		}
+	}
+
+	~ProfileZone() {
+		if (_start != 0) {
+			kengine::u64 end = profilerTicks();
+			--_currentDepth;
+			Profiler::get().record(_name, _start, end, _depth);
+		}
+	}
+
+	ProfileZone(ProfileZone const&) = delete;
+	ProfileZone& operator=(ProfileZone const&) = delete;
+
+private:
+	static thread_local kengine::u16 _currentDepth;
+
+	char const* _name;
+	kengine::u64 _start = 0;
+	kengine::u16 _depth = 0;
+};
+
+} // namespace kengine::core
+
+#define KENGINE_PROFILE_CONCAT_INNER(a, b) a##b
+#define KENGINE_PROFILE_CONCAT(a, b) KENGINE_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef KENGINE_PROFILER
+// the "" concatenation only compiles for string literals
+#define KENGINE_PROFILE_ZONE(name) ::kengine::core::ProfileZone KENGINE_PROFILE_CONCAT(_kengineProfileZone, __LINE__)("" name)
+#define KENGINE_PROFILE_FUNCTION() ::kengine::core::ProfileZone KENGINE_PROFILE_CONCAT(_kengineProfileZone, __LINE__)(__func__)
+#define KENGINE_PROFILE_FRAME() ::kengine::core::Profiler::get().frame()
+#else
+#define KENGINE_PROFILE_ZONE(name) do {} while (false)
+#define KENGINE_PROFILE_FUNCTION() do {} while (false)
+#define KENGINE_PROFILE_FRAME() do {} while (false)
+#endif
+
+#endif
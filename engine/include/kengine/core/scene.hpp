@@ -0,0 +1,116 @@
+#ifndef KENGINE_CORE_SCENE_HPP
+#define KENGINE_CORE_SCENE_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/core/transform.hpp>
+#include <kengine/util/span.hpp>
+#include <kengine/util/math/vector.hpp>
+#include <kengine/util/math/matrix.hpp>
+#include <kengine/util/math/quaternion.hpp>
+
+#include <vector>
+
+namespace kengine::core {
+
+// stable handle, ids are recycled after destroy
+struct SceneNode {
+	kengine::u32 id = ~0u;
+
+	bool isValid() const { return id != ~0u; }
+	bool operator==(SceneNode const& other) const { return id == other.id; }
+	bool operator!=(SceneNode const& other) const { return id != other.id; }
+};
+
+// runs task over [0, count) in chunks of about grain elements and returns once every chunk finished
+using SceneTask = void(*)(void* context, kengine::usize begin, kengine::usize end);
+using SceneDispatcher = void(*)(void* userData, kengine::usize count, kengine::usize grain, SceneTask task, void* context);
+
+// transform hierarchy stored as structure of arrays, dense indices are sorted by depth so every
+// level is a contiguous range whose parents all live in earlier levels
+class Scene {
+public:
+	static constexpr kengine::u32 invalidIndex = ~0u;
+
+	Scene();
+
+	SceneNode create(SceneNode parent = {});
+	SceneNode create(Transform const& transform, SceneNode parent = {});
+
+	// also destroys every descendant
+	void destroy(SceneNode node);
+
+	bool isAlive(SceneNode node) const;
+
+	SceneNode getParent(SceneNode node) const;
+	void setParent(SceneNode node, SceneNode parent);
+
+	util::math::Vector<f32, 3> getPosition(SceneNode node) const;
+	util::math::Quaternion<f32> getRotation(SceneNode node) const;
+	util::math::Vector<f32, 3> getScale(SceneNode node) const;
+
+	void setPosition(SceneNode node, util::math::Vector<f32, 3> const& position);
+	void setRotation(SceneNode node, util::math::Quaternion<f32> const& rotation);
+	void setScale(SceneNode node, util::math::Vector<f32, 3> const& scale);
+	void setTransform(SceneNode node, Transform const& transform);
+
+	// recomputes the world matrix of every dirty node and its descendants, one level at a time
+	void update();
+
+	// levels are split across the dispatcher, the default spreads them over the job system
+	void setDispatcher(SceneDispatcher dispatcher, void* userData);
+	void setGrainSize(kengine::usize grain) { _grain = grain; }
+
+	util::math::Matrix<f32, 4> const& getWorldMatrix(SceneNode node) const;
+
+	// dense order, valid until the next create/destroy/setParent
+	util::Span<util::math::Matrix<f32, 4> const> getWorldMatrices() const { return _worldMatrices; }
+	kengine::u32 getIndex(SceneNode node) const;
+
+	kengine::usize size() const { return _parents.size(); }
+
+private:
+	// keeps the listed dense indices in the given order, dropping the rest
+	void _reorder(std::vector<kengine::u32> const& order);
+
+	// restores depth order after a create or reparent broke it, and rebuilds the level ranges
+	void _sort();
+
+	void _computeLocalMatrices(kengine::usize begin, kengine::usize end);
+	void _computeWorldMatrices(kengine::usize begin, kengine::usize end);
+
+	std::vector<kengine::f32> _positionX;
+	std::vector<kengine::f32> _positionY;
+	std::vector<kengine::f32> _positionZ;
+	std::vector<kengine::f32> _rotationX;
+	std::vector<kengine::f32> _rotationY;
+	std::vector<kengine::f32> _rotationZ;
+	std::vector<kengine::f32> _rotationW;
+	std::vector<kengine::f32> _scaleX;
+	std::vector<kengine::f32> _scaleY;
+	std::vector<kengine::f32> _scaleZ;
+
+	std::vector<kengine::u32> _parents;
+	std::vector<kengine::u32> _depths;
+	std::vector<kengine::u8> _dirty;
+
+	// _levels[d] is the first index of depth d, with a final entry at size()
+	std::vector<kengine::u32> _levels;
+
+	std::vector<util::math::Matrix<f32, 4>> _localMatrices;
+	std::vector<util::math::Matrix<f32, 4>> _worldMatrices;
+
+	std::vector<kengine::u32> _handleToIndex;
+	std::vector<kengine::u32> _indexToHandle;
+	std::vector<kengine::u32> _freeHandles;
+
+	SceneDispatcher _dispatcher;
+	void* _dispatcherData = nullptr;
+	kengine::usize _grain = 1024;
+
+	bool _orderDirty = false;
+	bool _anyDirty = false;
+};
+
+} // namespace kengine::core
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef KENGINE_CORE_TAG_SLOT_HPP
+#define KENGINE_CORE_TAG_SLOT_HPP
+
+#include <kengine/types.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+namespace kengine::core {
+
+// precomputed handle for a tag, resolved once from the name
+struct TagId {
+	static constexpr kengine::u32 invalidIndex = ~0u;
+
+	kengine::u32 index = invalidIndex;
+
+	bool isValid() const { return index != invalidIndex; }
+
+	bool operator==(TagId const& other) const { return index == other.index; }
+	bool operator!=(TagId const& other) const { return index != other.index; }
+};
+
+// one published value behind a seqlock, readers never block the writer and retry when they raced it
+// the value lives in atomic words so a torn read is discarded instead of being a data race
+class alignas(64) TagSlot {
+public:
+	TagSlot(char const* payloadType, kengine::usize size)
+		: _payloadType(payloadType), _size(size), _words(std::make_unique<std::atomic<kengine::u64>[]>(wordCount(size))) {}
+
+	static constexpr kengine::usize wordCount(kengine::usize size) {
+		return (size + sizeof(kengine::u64) - 1) / sizeof(kengine::u64);
+	}
+
+	char const* getPayloadType() const { return _payloadType; }
+	kengine::usize getSize() const { return _size; }
+
+	template<typename T>
+	void write(T const& value) {
+		static_assert(std::is_trivially_copyable_v<T>, "Tag values must be trivially copyable");
+
+		kengine::u64 words[wordCount(sizeof(T))] = {};
+		std::memcpy(words, &value, sizeof(T));
+
+		// an odd sequence marks a write in progress, writers take turns on it
+		kengine::u32 sequence = _sequence.load(std::memory_order_relaxed);
+		while ((sequence & 1) != 0 || !_sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+			std::this_thread::yield();
+			sequence = _sequence.load(std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (kengine::usize i = 0; i < wordCount(sizeof(T)); ++i) {
+			_words[i].store(words[i], std::memory_order_relaxed);
+		}
+
+		_sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	template<typename T>
+	void read(T& value) const {
+		static_assert(std::is_trivially_copyable_v<T>, "Tag values must be trivially copyable");
+
+		kengine::u64 words[wordCount(sizeof(T))];
+		for (;;) {
+			kengine::u32 before = _sequence.load(std::memory_order_acquire);
+			if ((before & 1) != 0) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			for (kengine::usize i = 0; i < wordCount(sizeof(T)); ++i) {
+				words[i] = _words[i].load(std::memory_order_relaxed);
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (_sequence.load(std::memory_order_relaxed) == before) {
+				break;
+			}
+		}
+
+		std::memcpy(&value, words, sizeof(T));
+	}
+
+private:
+	std::atomic<kengine::u32> _sequence = 0;
+	char const* _payloadType;
+	kengine::usize _size;
+	std::unique_ptr<std::atomic<kengine::u64>[]> _words;
+};
+
+} // namespace kengine::core
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef KENGINE_CORE_TIMING_HPP
+#define KENGINE_CORE_TIMING_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/core/platform/platform.hpp>
+
+namespace kengine::core {
+
+// accumulates frame time and hands it out in fixed steps, alpha is how far the leftover reaches into the next step
+class FixedTimestep {
+public:
+	FixedTimestep(kengine::f64 step = 1.0 / 60.0, kengine::u32 maxSteps = 8) : _step(step), _maxSteps(maxSteps) {}
+
+	// returns how many steps to simulate for this frame, time beyond maxSteps is dropped so a stall cannot snowball
+	kengine::u32 advance(kengine::f64 frameTime);
+
+	kengine::f64 getStep() const { return _step; }
+	kengine::f64 getAlpha() const { return _accumulator / _step; }
+
+	void reset() { _accumulator = 0; }
+
+private:
+	kengine::f64 _step;
+	kengine::u32 _maxSteps;
+	kengine::f64 _accumulator = 0;
+};
+
+// holds frames to a target duration, sleeps most of the wait and spins the last stretch for precision
+class FramePacer {
+public:
+	FramePacer(kengine::f64 targetFrameTime = 1.0 / 60.0, kengine::f64 spinTime = 0.002) : _target(targetFrameTime), _spin(spinTime) {}
+
+	// 0 disables pacing
+	void setTargetFrameTime(kengine::f64 targetFrameTime) { _target = targetFrameTime; }
+	kengine::f64 getTargetFrameTime() const { return _target; }
+
+	// waits for the end of the current frame slot and starts the next one
+	void wait(platform::IPlatform& platform);
+
+private:
+	kengine::f64 _target;
+	kengine::f64 _spin;
+	kengine::f64 _deadline = -1.0;
+};
+
+} // namespace kengine::core
+
+#endif
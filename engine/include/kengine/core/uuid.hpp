@@ -2,6 +2,8 @@
 #define KENGINE_CORE_UUID_HPP
 
 #include <random>
+#include <sstream>
+#include <string>
 
 #include <kengine/types.hpp>
 #include <kengine/singleton.hpp>
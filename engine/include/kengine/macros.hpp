@@ -14,4 +14,12 @@
 #error "Unsupported platform"
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KENGINE_SIMD_SSE2
+#endif
+
+#if defined(__F16C__) || defined(__AVX2__)
+#define KENGINE_SIMD_F16C
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef KENGINE_UTIL_DELEGATE_HPP
+#define KENGINE_UTIL_DELEGATE_HPP
+
+#include <kengine/types.hpp>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace kengine::util {
+
+template<typename Signature>
+class Delegate;
+
+// callable stored inline, so binding a function, a member function or a small lambda never allocates
+template<typename Return, typename... Args>
+class Delegate<Return(Args...)> {
+public:
+	static constexpr kengine::usize inlineSize = 4 * sizeof(void*);
+
+	Delegate() = default;
+
+	template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Delegate>>>
+	Delegate(F&& callable) {
+		_store(std::forward<F>(callable));
+	}
+
+	template<typename Object>
+	Delegate(Object* object, Return (Object::*method)(Args...)) {
+		_store([object, method](Args... args) -> Return { return (object->*method)(std::forward<Args>(args)...); });
+	}
+
+	template<typename Object>
+	Delegate(Object const* object, Return (Object::*method)(Args...) const) {
+		_store([object, method](Args... args) -> Return { return (object->*method)(std::forward<Args>(args)...); });
+	}
+
+	explicit operator bool() const { return _invoke != nullptr; }
+
+	Return operator()(Args... args) const {
+		return _invoke(_storage, std::forward<Args>(args)...);
+	}
+
+private:
+	template<typename F>
+	void _store(F&& callable) {
+		using Callable = std::decay_t<F>;
+		static_assert(sizeof(Callable) <= inlineSize, "Delegate callable does not fit the inline storage, capture less or capture a pointer");
+		static_assert(alignof(Callable) <= alignof(std::max_align_t), "Delegate callable is over-aligned");
+		static_assert(std::is_trivially_copyable_v<Callable> && std::is_trivially_destructible_v<Callable>, "Delegate only stores trivially copyable callables, capture pointers instead of owning objects");
+
+		new (_storage) Callable(std::forward<F>(callable));
+		_invoke = [](void* storage, Args... args) -> Return {
+			return (*std::launder(static_cast<Callable*>(storage)))(std::forward<Args>(args)...);
+		};
+	}
+
+	alignas(std::max_align_t) mutable unsigned char _storage[inlineSize] = {};
+	Return (*_invoke)(void*, Args...) = nullptr;
+};
+
+} // namespace kengine::util
+
+#endif
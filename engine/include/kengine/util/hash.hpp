@@ -0,0 +1,38 @@
+#ifndef KENGINE_UTIL_HASH_HPP
+#define KENGINE_UTIL_HASH_HPP
+
+#include <kengine/types.hpp>
+
+#include <string_view>
+
+namespace kengine::util {
+
+constexpr kengine::u64 fnv1aOffsetBasis = 0xcbf29ce484222325ull;
+constexpr kengine::u64 fnv1aPrime = 0x100000001b3ull;
+
+// 64-bit FNV-1a, usable at compile time so names can be hashed once and looked up by value
+constexpr kengine::u64 hash(std::string_view string) {
+	kengine::u64 result = fnv1aOffsetBasis;
+	for (char c : string) {
+		result ^= static_cast<kengine::u8>(c);
+		result *= fnv1aPrime;
+	}
+
+	return result;
+}
+
+constexpr kengine::u64 hash(const char* string, kengine::usize length) {
+	return hash(std::string_view(string, length));
+}
+
+namespace literals {
+
+constexpr kengine::u64 operator""_hash(const char* string, kengine::usize length) {
+	return kengine::util::hash(string, length);
+}
+
+} // namespace literals
+
+} // namespace kengine::util
+
+#endif
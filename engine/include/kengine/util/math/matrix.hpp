@@ -0,0 +1,94 @@
+#ifndef KENGINE_UTIL_MATH_MATRIX_HPP
+#define KENGINE_UTIL_MATH_MATRIX_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/util/math/vector.hpp>
+
+namespace kengine::util::math {
+
+// square, column-major to match OpenGL
+template<typename T, kengine::usize N>
+class Matrix {
+public:
+	Matrix() {
+		for (kengine::usize i = 0; i < N * N; ++i) {
+			_data[i] = T();
+		}
+	}
+
+	Matrix(const T* data) {
+		for (kengine::usize i = 0; i < N * N; ++i) {
+			_data[i] = data[i];
+		}
+	}
+
+	static Matrix<T, N> identity() {
+		Matrix<T, N> result;
+		for (kengine::usize i = 0; i < N; ++i) {
+			result(i, i) = T(1);
+		}
+		return result;
+	}
+
+	T& operator()(kengine::usize row, kengine::usize column) {
+		return _data[column * N + row];
+	}
+
+	const T& operator()(kengine::usize row, kengine::usize column) const {
+		return _data[column * N + row];
+	}
+
+	Matrix<T, N> operator*(const Matrix<T, N>& other) const {
+		Matrix<T, N> result;
+		for (kengine::usize column = 0; column < N; ++column) {
+			for (kengine::usize row = 0; row < N; ++row) {
+				T sum = T();
+				for (kengine::usize k = 0; k < N; ++k) {
+					sum += (*this)(row, k) * other(k, column);
+				}
+				result(row, column) = sum;
+			}
+		}
+		return result;
+	}
+
+	Vector<T, N> operator*(const Vector<T, N>& vector) const {
+		Vector<T, N> result;
+		for (kengine::usize row = 0; row < N; ++row) {
+			T sum = T();
+			for (kengine::usize k = 0; k < N; ++k) {
+				sum += (*this)(row, k) * vector[k];
+			}
+			result[row] = sum;
+		}
+		return result;
+	}
+
+	bool operator==(const Matrix<T, N>& other) const {
+		for (kengine::usize i = 0; i < N * N; ++i) {
+			if (_data[i] != other._data[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool operator!=(const Matrix<T, N>& other) const {
+		return !(*this == other);
+	}
+
+	T* data() {
+		return _data;
+	}
+
+	const T* data() const {
+		return _data;
+	}
+
+private:
+	T _data[N * N];
+};
+
+} // namespace kengine::util::math
+
+#endif
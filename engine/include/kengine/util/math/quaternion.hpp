@@ -0,0 +1,91 @@
+#ifndef KENGINE_UTIL_MATH_QUATERNION_HPP
+#define KENGINE_UTIL_MATH_QUATERNION_HPP
+
+#include <kengine/types.hpp>
+#include <kengine/util/math/vector.hpp>
+#include <kengine/util/math/matrix.hpp>
+
+#include <cmath>
+
+namespace kengine::util::math {
+
+template<typename T>
+struct Quaternion {
+	T x = T();
+	T y = T();
+	T z = T();
+	T w = T(1);
+
+	// same order as the renderer's Euler rotation, X first, then Y, then Z
+	static Quaternion<T> fromEuler(const Vector<T, 3>& euler) {
+		T sx = std::sin(euler[0] * T(0.5));
+		T cx = std::cos(euler[0] * T(0.5));
+		T sy = std::sin(euler[1] * T(0.5));
+		T cy = std::cos(euler[1] * T(0.5));
+		T sz = std::sin(euler[2] * T(0.5));
+		T cz = std::cos(euler[2] * T(0.5));
+
+		return {
+			sx * cy * cz - cx * sy * sz,
+			cx * sy * cz + sx * cy * sz,
+			cx * cy * sz - sx * sy * cz,
+			cx * cy * cz + sx * sy * sz,
+		};
+	}
+
+	static Quaternion<T> fromAxisAngle(const Vector<T, 3>& axis, T angle) {
+		T s = std::sin(angle * T(0.5));
+		return { axis[0] * s, axis[1] * s, axis[2] * s, std::cos(angle * T(0.5)) };
+	}
+
+	Quaternion<T> operator*(const Quaternion<T>& other) const {
+		return {
+			w * other.x + x * other.w + y * other.z - z * other.y,
+			w * other.y - x * other.z + y * other.w + z * other.x,
+			w * other.z + x * other.y - y * other.x + z * other.w,
+			w * other.w - x * other.x - y * other.y - z * other.z,
+		};
+	}
+
+	Quaternion<T> conjugate() const {
+		return { -x, -y, -z, w };
+	}
+
+	T dot(const Quaternion<T>& other) const {
+		return x * other.x + y * other.y + z * other.z + w * other.w;
+	}
+
+	Quaternion<T> normalize() const {
+		T length = std::sqrt(dot(*this));
+		return { x / length, y / length, z / length, w / length };
+	}
+
+	Vector<T, 3> rotate(const Vector<T, 3>& v) const {
+		Vector<T, 3> u = { x, y, z };
+		Vector<T, 3> t = cross(u, v) * T(2);
+		return v + t * w + cross(u, t);
+	}
+
+	Matrix<T, 4> toMatrix() const {
+		Matrix<T, 4> result = Matrix<T, 4>::identity();
+		result(0, 0) = T(1) - T(2) * (y * y + z * z);
+		result(1, 0) = T(2) * (x * y + z * w);
+		result(2, 0) = T(2) * (x * z - y * w);
+		result(0, 1) = T(2) * (x * y - z * w);
+		result(1, 1) = T(1) - T(2) * (x * x + z * z);
+		result(2, 1) = T(2) * (y * z + x * w);
+		result(0, 2) = T(2) * (x * z + y * w);
+		result(1, 2) = T(2) * (y * z - x * w);
+		result(2, 2) = T(1) - T(2) * (x * x + y * y);
+		return result;
+	}
+
+private:
+	static Vector<T, 3> cross(const Vector<T, 3>& a, const Vector<T, 3>& b) {
+		return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+	}
+};
+
+} // namespace kengine::util::math
+
+#endif
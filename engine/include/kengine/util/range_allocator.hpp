@@ -0,0 +1,101 @@
+#ifndef KENGINE_UTIL_RANGE_ALLOCATOR_HPP
+#define KENGINE_UTIL_RANGE_ALLOCATOR_HPP
+
+#include <kengine/types.hpp>
+
+#include <map>
+#include <iterator>
+
+namespace kengine::util {
+
+// first-fit free-list allocator handing out [offset, offset + size) ranges of an externally owned resource
+class RangeAllocator {
+public:
+	static constexpr kengine::u64 invalidOffset = static_cast<kengine::u64>(-1);
+
+	RangeAllocator() = default;
+	RangeAllocator(kengine::u64 capacity) { reset(capacity); }
+
+	void reset(kengine::u64 capacity) {
+		_freeRanges.clear();
+		_capacity = capacity;
+		_freeSize = capacity;
+		if (capacity > 0) {
+			_freeRanges[0] = capacity;
+		}
+	}
+
+	kengine::u64 allocate(kengine::u64 size) {
+		if (size == 0) {
+			return invalidOffset;
+		}
+
+		for (auto it = _freeRanges.begin(); it != _freeRanges.end(); ++it) {
+			if (it->second < size) {
+				continue;
+			}
+
+			kengine::u64 offset = it->first;
+			kengine::u64 remaining = it->second - size;
+			_freeRanges.erase(it);
+			if (remaining > 0) {
+				_freeRanges[offset + size] = remaining;
+			}
+
+			_freeSize -= size;
+			return offset;
+		}
+
+		return invalidOffset;
+	}
+
+	void free(kengine::u64 offset, kengine::u64 size) {
+		if (offset == invalidOffset || size == 0) {
+			return;
+		}
+
+		auto next = _freeRanges.lower_bound(offset);
+		if (next != _freeRanges.begin()) {
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == offset) {
+				offset = previous->first;
+				size += previous->second;
+				_freeSize -= previous->second;
+				_freeRanges.erase(previous);
+			}
+		}
+
+		if (next != _freeRanges.end() && offset + size == next->first) {
+			size += next->second;
+			_freeSize -= next->second;
+			_freeRanges.erase(next);
+		}
+
+		_freeRanges[offset] = size;
+		_freeSize += size;
+	}
+
+	// extends the managed range, new space is merged with a trailing free range
+	void grow(kengine::u64 capacity) {
+		if (capacity <= _capacity) {
+			return;
+		}
+
+		kengine::u64 offset = _capacity;
+		_capacity = capacity;
+		free(offset, capacity - offset);
+	}
+
+	kengine::u64 getCapacity() const { return _capacity; }
+	kengine::u64 getFreeSize() const { return _freeSize; }
+	kengine::usize getFreeRangeCount() const { return _freeRanges.size(); }
+
+private:
+	std::map<kengine::u64, kengine::u64> _freeRanges;
+	kengine::u64 _capacity = 0;
+	kengine::u64 _freeSize = 0;
+};
+
+} // namespace kengine::util
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef KENGINE_UTIL_SPAN_HPP
+#define KENGINE_UTIL_SPAN_HPP
+
+#include <kengine/types.hpp>
+
+#include <vector>
+#include <type_traits>
+
+namespace kengine::util {
+
+// non-owning view over contiguous elements
+template<typename T>
+class Span {
+public:
+	Span() = default;
+	Span(T* data, kengine::usize size) : _data(data), _size(size) {}
+
+	template<typename U, typename = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+	Span(Span<U> const& other) : _data(other.data()), _size(other.size()) {}
+
+	template<typename U, typename = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+	Span(std::vector<U>& vector) : _data(vector.data()), _size(vector.size()) {}
+
+	template<typename U, typename = std::enable_if_t<std::is_convertible_v<U const(*)[], T(*)[]>>>
+	Span(std::vector<U> const& vector) : _data(vector.data()), _size(vector.size()) {}
+
+	T& operator[](kengine::usize index) const { return _data[index]; }
+
+	T* data() const { return _data; }
+	kengine::usize size() const { return _size; }
+	bool empty() const { return _size == 0; }
+
+	T* begin() const { return _data; }
+	T* end() const { return _data + _size; }
+
+	Span<T> subspan(kengine::usize offset, kengine::usize count) const {
+		return Span<T>(_data + offset, count);
+	}
+
+private:
+	T* _data = nullptr;
+	kengine::usize _size = 0;
+};
+
+} // namespace kengine::util
+
+#endif
@@ -0,0 +1,125 @@
+#include <kengine/core/binary_logger.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace kengine::core {
+
+namespace {
+
+template<typename T>
+void writeValue(kengine::u8*& cursor, T value) {
+	std::memcpy(cursor, &value, sizeof(T));
+	cursor += sizeof(T);
+}
+
+// a format entry stores its length in 16 bits, longer formats are cut to fit
+constexpr kengine::usize maxFormatLength = 0xFFFF;
+
+kengine::u64 nanosecondsSinceEpoch(std::chrono::nanoseconds time) {
+	return static_cast<kengine::u64>(time.count());
+}
+
+} // namespace
+
+BinaryLogger::BinaryLogger(std::string const& basePath, kengine::usize fileSize, kengine::u32 fileCount)
+	: _basePath(basePath), _fileSize(fileSize), _fileCount(fileCount > 0 ? fileCount : 1) {
+	_rotate();
+}
+
+BinaryLogger::~BinaryLogger() {
+	_file.close(_offset);
+}
+
+void BinaryLogger::log(LogSeverity severity, std::string const& message) {
+	kengine::u8 buffer[LogRecordWriter::maxRecordSize];
+	LogRecordWriter writer(buffer, severity, "{}");
+	writer.putString(message);
+	writer.finish(logTimestamp());
+
+	logRecord(buffer);
+}
+
+bool BinaryLogger::logRecord(kengine::u8 const* record) {
+	LogRecord header;
+	std::memcpy(&header, record, sizeof(LogRecord));
+
+	kengine::usize argumentSize = header.size - sizeof(LogRecord);
+	kengine::usize recordSize = binaryLogRecordEntrySize + argumentSize;
+	kengine::usize formatLength = std::min(std::strlen(header.format), maxFormatLength);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_file.isOpen()) {
+		return true;
+	}
+
+	auto format = _formats.find(header.format);
+	kengine::usize formatSize = format == _formats.end() ? binaryLogFormatEntrySize + formatLength : 0;
+
+	if (_offset + formatSize + recordSize > _file.getSize()) {
+		if (!_rotate()) {
+			return true;
+		}
+
+		format = _formats.end();
+		formatSize = binaryLogFormatEntrySize + formatLength;
+	}
+
+	// would not fit in an empty file either
+	if (_offset + formatSize + recordSize > _file.getSize()) {
+		return true;
+	}
+
+	kengine::u8* cursor = _file.getData() + _offset;
+
+	kengine::u32 formatId;
+	if (format == _formats.end()) {
+		formatId = static_cast<kengine::u32>(_formats.size());
+		_formats.emplace(header.format, formatId);
+
+		writeValue(cursor, BinaryLogEntry::Format);
+		writeValue<kengine::u8>(cursor, 0);
+		writeValue(cursor, static_cast<kengine::u16>(formatLength));
+		writeValue(cursor, formatId);
+		std::memcpy(cursor, header.format, formatLength);
+		cursor += formatLength;
+	} else {
+		formatId = format->second;
+	}
+
+	writeValue(cursor, BinaryLogEntry::Record);
+	writeValue(cursor, static_cast<kengine::s8>(header.severity));
+	writeValue(cursor, static_cast<kengine::u16>(argumentSize));
+	writeValue(cursor, formatId);
+	writeValue(cursor, header.time);
+	std::memcpy(cursor, record + sizeof(LogRecord), argumentSize);
+	cursor += argumentSize;
+
+	_offset = static_cast<kengine::usize>(cursor - _file.getData());
+	return true;
+}
+
+bool BinaryLogger::_rotate() {
+	_file.close(_offset);
+	_formats.clear();
+	_offset = 0;
+
+	std::string path = _basePath + "." + std::to_string(_sequence % _fileCount) + ".klog";
+	if (!_file.create(path, _fileSize) || _fileSize < sizeof(BinaryLogHeader)) {
+		return false;
+	}
+
+	BinaryLogHeader header = {};
+	std::memcpy(header.magic, "KLOG", 4);
+	header.version = binaryLogVersion;
+	header.sequence = _sequence++;
+	header.steadyNanoseconds = logTimestamp();
+	header.systemNanoseconds = nanosecondsSinceEpoch(std::chrono::system_clock::now().time_since_epoch());
+
+	std::memcpy(_file.getData(), &header, sizeof(BinaryLogHeader));
+	_offset = sizeof(BinaryLogHeader);
+	return true;
+}
+
+} // namespace kengine::core
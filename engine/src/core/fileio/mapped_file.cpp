@@ -0,0 +1,115 @@
+#include <kengine/core/fileio/mapped_file.hpp>
+
+#include <algorithm>
+
+#ifdef KENGINE_PLATFORM_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace kengine::core::fileio {
+
+#ifdef KENGINE_PLATFORM_WINDOWS
+
+bool MappedFile::create(std::string const& path, kengine::usize size) {
+	close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	ULARGE_INTEGER mappingSize;
+	mappingSize.QuadPart = size;
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, mappingSize.HighPart, mappingSize.LowPart, nullptr);
+	if (mapping == nullptr) {
+		CloseHandle(file);
+		return false;
+	}
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+	if (data == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	_file = file;
+	_mapping = mapping;
+	_data = static_cast<kengine::u8*>(data);
+	_size = size;
+	return true;
+}
+
+void MappedFile::close(kengine::usize usedSize) {
+	if (_data == nullptr) {
+		return;
+	}
+
+	UnmapViewOfFile(_data);
+	CloseHandle(_mapping);
+
+	LARGE_INTEGER end;
+	end.QuadPart = static_cast<LONGLONG>(std::min(usedSize, _size));
+	SetFilePointerEx(_file, end, nullptr, FILE_BEGIN);
+	SetEndOfFile(_file);
+	CloseHandle(_file);
+
+	_data = nullptr;
+	_size = 0;
+	_file = nullptr;
+	_mapping = nullptr;
+}
+
+#else
+
+bool MappedFile::create(std::string const& path, kengine::usize size) {
+	close();
+
+	int descriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (descriptor < 0) {
+		return false;
+	}
+
+	if (::ftruncate(descriptor, static_cast<off_t>(size)) != 0) {
+		::close(descriptor);
+		return false;
+	}
+
+	void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	if (data == MAP_FAILED) {
+		::close(descriptor);
+		return false;
+	}
+
+	_descriptor = descriptor;
+	_data = static_cast<kengine::u8*>(data);
+	_size = size;
+	return true;
+}
+
+void MappedFile::close(kengine::usize usedSize) {
+	if (_data == nullptr) {
+		return;
+	}
+
+	::munmap(_data, _size);
+	if (::ftruncate(_descriptor, static_cast<off_t>(std::min(usedSize, _size))) != 0) {
+		// the file keeps its zeroed tail, readers stop at the first zero byte anyway
+	}
+	::close(_descriptor);
+
+	_data = nullptr;
+	_size = 0;
+	_descriptor = -1;
+}
+
+#endif
+
+} // namespace kengine::core::fileio
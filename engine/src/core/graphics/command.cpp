@@ -0,0 +1,138 @@
+#include <kengine/core/graphics/command.hpp>
+#include <kengine/core/platform/memory.hpp>
+
+#include <cstring>
+
+namespace kengine::core::graphics {
+
+kengine::u32 sortKeyDepth(kengine::f32 depth, bool backToFront) {
+	if (!(depth > 0.0f)) {
+		depth = 0.0f;
+	}
+
+	// the bit pattern of a non-negative float increases monotonically with its value
+	kengine::u32 bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	return backToFront ? ~bits : bits;
+}
+
+CommandBuffer::CommandBuffer(kengine::usize byteCapacity, kengine::usize commandCapacity) : _byteCapacity(byteCapacity), _commandCapacity(commandCapacity) {
+	_data = static_cast<kengine::u8*>(platform::Memory::get().allocAligned(_byteCapacity, platform::AllocationTag::Graphics));
+	_entries = platform::Memory::get().allocArray<CommandEntry>(platform::AllocationTag::Graphics, _commandCapacity);
+}
+
+CommandBuffer::~CommandBuffer() {
+	platform::Memory::get().deallocArray<CommandEntry>(_entries);
+	platform::Memory::get().deallocAligned(_data, _byteCapacity);
+}
+
+ClearCommand* CommandBuffer::clear(kengine::u64 key, util::math::Vector<f32, 4> const& color, kengine::u32 flags) {
+	ClearCommand* command = push<ClearCommand>(key);
+	if (command != nullptr) {
+		command->color = color;
+		command->flags = flags;
+	}
+
+	return command;
+}
+
+ViewportCommand* CommandBuffer::viewport(kengine::u64 key, kengine::s32 x, kengine::s32 y, kengine::u32 width, kengine::u32 height) {
+	ViewportCommand* command = push<ViewportCommand>(key);
+	if (command != nullptr) {
+		command->x = x;
+		command->y = y;
+		command->width = width;
+		command->height = height;
+	}
+
+	return command;
+}
+
+StateCommand* CommandBuffer::state(kengine::u64 key, kengine::u32 state) {
+	StateCommand* command = push<StateCommand>(key);
+	if (command != nullptr) {
+		command->state = state;
+	}
+
+	return command;
+}
+
+DrawCommand* CommandBuffer::draw(kengine::u64 key, IMesh* mesh, Transform const& transform, kengine::u32 material) {
+	DrawCommand* command = push<DrawCommand>(key);
+	if (command != nullptr) {
+		command->mesh = mesh;
+		command->material = material;
+		command->transform = transform;
+	}
+
+	return command;
+}
+
+DrawCommand* CommandBuffer::draw(kengine::u64 key, IObject const& object, kengine::u32 material) {
+	return draw(key, object.getMesh(), object.transform, material);
+}
+
+void CommandBuffer::reset() {
+	_offset = 0;
+	_count = 0;
+	_overflowed = false;
+}
+
+void CommandQueue::submit(CommandBuffer const& buffer) {
+	if (buffer.hasOverflowed()) {
+		KENGINE_LOG(Graphics, Warning, "CommandQueue::submit: Command buffer overflowed, {} commands were kept", buffer.getCommandCount());
+	}
+
+	_entries.insert(_entries.end(), buffer.getEntries(), buffer.getEntries() + buffer.getCommandCount());
+}
+
+void CommandQueue::sort() {
+	kengine::usize count = _entries.size();
+	if (count < 2) {
+		return;
+	}
+
+	// build all eight byte histograms in a single sweep
+	kengine::usize histograms[8][256] = {};
+	for (CommandEntry const& entry : _entries) {
+		for (kengine::usize pass = 0; pass < 8; ++pass) {
+			++histograms[pass][(entry.key >> (pass * 8)) & 0xFF];
+		}
+	}
+
+	_scratch.resize(count);
+	CommandEntry* source = _entries.data();
+	CommandEntry* destination = _scratch.data();
+
+	for (kengine::usize pass = 0; pass < 8; ++pass) {
+		kengine::usize* histogram = histograms[pass];
+		kengine::usize shift = pass * 8;
+
+		if (histogram[(source[0].key >> shift) & 0xFF] == count) {
+			continue;
+		}
+
+		kengine::usize offset = 0;
+		for (kengine::usize i = 0; i < 256; ++i) {
+			kengine::usize bucket = histogram[i];
+			histogram[i] = offset;
+			offset += bucket;
+		}
+
+		for (kengine::usize i = 0; i < count; ++i) {
+			destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+		}
+
+		std::swap(source, destination);
+	}
+
+	if (source != _entries.data()) {
+		_entries.swap(_scratch);
+	}
+}
+
+void CommandQueue::clear() {
+	_entries.clear();
+}
+
+} // namespace kengine::core::graphics
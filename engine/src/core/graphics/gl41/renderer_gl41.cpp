@@ -1,6 +1,9 @@
 #include "renderer_gl41.hpp"
 
 #include <stdexcept>
+#include <cstddef>
+#include <chrono>
+#include <string>
 
 #include <kengine/core/graphics/renderer.hpp>
 #include <kengine/core/exception.hpp>
@@ -18,10 +21,6 @@ typedef HGLRC(WINAPI* PFNWGLCREATECONTEXTATTRIBSARBPROC) (HDC, HGLRC, const int*
 
 namespace kengine::core::graphics::gl41 {
 
-struct Vertex {
-	float x, y, z;
-};
-
 RendererGL41::RendererGL41(window::IWindow& window) : _window(window) {
 	_initGL();
 
@@ -76,10 +75,30 @@ void main() {
 		throw Exception("Failed to compile lit shader");
 	}
 
+	using namespace util::literals;
+
+	_litShader.bind();
+	_litShader.setUniform("u_colorSampler"_hash, GLint(0));
+	_litShader.setUniform("u_positionSampler"_hash, GLint(1));
+	_litShader.setUniform("u_normalSampler"_hash, GLint(2));
+	_litShader.flush();
+
+	_indexArenas[static_cast<kengine::usize>(IndexFormat::U16)].create(sizeof(kengine::u16), 3 << 16);
+	_indexArenas[static_cast<kengine::usize>(IndexFormat::U32)].create(sizeof(kengine::u32), 3 << 14);
+
 	glViewport(0, 0, 800, 600);
 }
 
 RendererGL41::~RendererGL41() {
+	for (IObject* object : _objects) {
+		delete object;
+	}
+
+	for (MeshGL* mesh : _meshes) {
+		delete mesh;
+	}
+
+	_vertexPools.clear();
 	_deinitGL();
 }
 
@@ -155,11 +174,35 @@ void RendererGL41::_swapBuffers() {
 }
 
 void RendererGL41::render() {
+	using clock = std::chrono::steady_clock;
+
+	kengine::u64 frameCount = _statistics.frameCount + 1;
+	_statistics = RenderStatistics();
+	_statistics.frameCount = frameCount;
+	_statistics.commandCount = _commands.size();
+
 	_intermediateFramebuffers[0].bindForDrawing();
 
 	glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT);
 
+	clock::time_point start = clock::now();
+	_commands.sort();
+	clock::time_point sorted = clock::now();
+
+	_boundPool = nullptr;
+	for (CommandEntry const& entry : _commands) {
+		_execute(*entry.packet);
+	}
+	glBindVertexArray(0);
+
+	_commands.clear();
+	clock::time_point replayed = clock::now();
+
+	// replay time is CPU side submission, the GPU may still be working on it
+	_statistics.sortMilliseconds = std::chrono::duration<kengine::f64, std::milli>(sorted - start).count();
+	_statistics.replayMilliseconds = std::chrono::duration<kengine::f64, std::milli>(replayed - sorted).count();
+
 	_intermediateFramebuffers[0].bindForReading();
 	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
@@ -168,12 +211,366 @@ void RendererGL41::render() {
 	_swapBuffers();
 }
 
-IMesh* RendererGL41::createMesh() {
-	return nullptr;
+void RendererGL41::submit(CommandBuffer const& commands) {
+	_commands.submit(commands);
+}
+
+void RendererGL41::_execute(CommandPacket const& packet) {
+	switch (packet.type) {
+	case CommandType::Clear: {
+		ClearCommand const& command = packet.as<ClearCommand>();
+		GLbitfield mask = 0;
+		if (command.flags & ClearColor) {
+			glClearColor(command.color[0], command.color[1], command.color[2], command.color[3]);
+			mask |= GL_COLOR_BUFFER_BIT;
+		}
+
+		if (command.flags & ClearDepth) {
+			glClearDepth(command.depth);
+			mask |= GL_DEPTH_BUFFER_BIT;
+		}
+
+		glClear(mask);
+		++_statistics.clearCount;
+		break;
+	}
+	case CommandType::Viewport: {
+		ViewportCommand const& command = packet.as<ViewportCommand>();
+		glViewport(command.x, command.y, static_cast<GLsizei>(command.width), static_cast<GLsizei>(command.height));
+		++_statistics.viewportCount;
+		break;
+	}
+	case CommandType::State:
+		_applyState(packet.as<StateCommand>().state);
+		break;
+	case CommandType::Draw:
+		_draw(packet.as<DrawCommand>());
+		break;
+	}
+}
+
+void RendererGL41::_applyState(kengine::u32 state) {
+	kengine::u32 changed = state ^ _state;
+	if (changed == 0) {
+		return;
+	}
+
+	if (changed & StateDepthTest) {
+		(state & StateDepthTest) ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+	}
+
+	if (changed & StateDepthWrite) {
+		glDepthMask((state & StateDepthWrite) ? GL_TRUE : GL_FALSE);
+	}
+
+	if (changed & StateBlend) {
+		(state & StateBlend) ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+	}
+
+	if (changed & StateCullBackFaces) {
+		(state & StateCullBackFaces) ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+	}
+
+	_state = state;
+	++_statistics.stateChangeCount;
+}
+
+void RendererGL41::_draw(DrawCommand const& command) {
+	if (command.mesh == nullptr) {
+		return;
+	}
+
+	MeshGL const& mesh = *static_cast<MeshGL const*>(command.mesh);
+	MeshLOD range = _selectDrawRange(command);
+	if (mesh._vertexCapacity == 0 || range.firstIndex >= mesh._indices.size()) {
+		return;
+	}
+
+	kengine::u64 indexCount = std::min<kengine::u64>(range.indexCount, mesh._indices.size() - range.firstIndex);
+	if (indexCount == 0) {
+		return;
+	}
+
+	VertexPoolGL& pool = mesh._pool;
+	if (&pool != _boundPool) {
+		_boundPool = &pool;
+		_boundIndexFormat = mesh._indexFormat;
+		pool.shader.bind();
+		glBindVertexArray(pool.vertexArrays[static_cast<kengine::usize>(_boundIndexFormat)]);
+	} else if (mesh._indexFormat != _boundIndexFormat) {
+		_boundIndexFormat = mesh._indexFormat;
+		glBindVertexArray(pool.vertexArrays[static_cast<kengine::usize>(_boundIndexFormat)]);
+	}
+
+	pool.shader.setUniform(pool.positionUniform, command.transform.position);
+	pool.shader.setUniform(pool.rotationUniform, command.transform.rotation);
+	pool.shader.setUniform(pool.scaleUniform, command.transform.scale);
+	pool.shader.setUniform(pool.boundsCenterUniform, mesh._bounds.center);
+	pool.shader.setUniform(pool.boundsExtentUniform, mesh._bounds.extent);
+	pool.shader.flush();
+
+	GLenum indexType = mesh._indexFormat == IndexFormat::U16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	kengine::u64 firstIndex = mesh._indexOffset + range.firstIndex;
+	glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(indexCount), indexType, reinterpret_cast<void*>(firstIndex * indexFormatSize(mesh._indexFormat)), static_cast<GLint>(mesh._vertexOffset));
+
+	++_statistics.drawCount;
+	_statistics.triangleCount += indexCount / 3;
+}
+
+VertexPoolGL& RendererGL41::_getVertexPool(VertexLayout const& layout) {
+	for (std::unique_ptr<VertexPoolGL> const& pool : _vertexPools) {
+		if (pool->layout == layout) {
+			return *pool;
+		}
+	}
+
+	std::unique_ptr<VertexPoolGL> created = std::make_unique<VertexPoolGL>();
+	VertexPoolGL& pool = *created;
+	pool.layout = layout;
+
+	std::string geometryVertexShaderSource = "#version 410 core\n";
+	if (layout.position == PositionFormat::Snorm16) {
+		geometryVertexShaderSource += "#define KENGINE_POSITION_SNORM16\n";
+	}
+
+	if (layout.normal == NormalFormat::Octahedral16) {
+		geometryVertexShaderSource += "#define KENGINE_NORMAL_OCTAHEDRAL\n";
+	}
+
+	geometryVertexShaderSource += R"(
+layout(location = 0) in vec4 a_position;
+#ifdef KENGINE_NORMAL_OCTAHEDRAL
+layout(location = 1) in vec2 a_normal;
+#else
+layout(location = 1) in vec3 a_normal;
+#endif
+layout(location = 2) in vec2 a_texCoords;
+
+uniform vec3 u_position;
+uniform vec3 u_rotation;
+uniform vec3 u_scale;
+uniform vec3 u_boundsCenter;
+uniform vec3 u_boundsExtent;
+
+out vec3 v_position;
+out vec3 v_normal;
+out vec2 v_uv;
+
+mat3 rotationMatrix(vec3 euler) {
+	vec3 s = sin(euler);
+	vec3 c = cos(euler);
+
+	mat3 x = mat3(1.0, 0.0, 0.0, 0.0, c.x, s.x, 0.0, -s.x, c.x);
+	mat3 y = mat3(c.y, 0.0, -s.y, 0.0, 1.0, 0.0, s.y, 0.0, c.y);
+	mat3 z = mat3(c.z, s.z, 0.0, -s.z, c.z, 0.0, 0.0, 0.0, 1.0);
+	return z * y * x;
+}
+
+vec3 decodeNormal() {
+#ifdef KENGINE_NORMAL_OCTAHEDRAL
+	vec3 n = vec3(a_normal, 1.0 - abs(a_normal.x) - abs(a_normal.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+#else
+	return a_normal;
+#endif
+}
+
+void main() {
+#ifdef KENGINE_POSITION_SNORM16
+	vec3 local = a_position.xyz * u_boundsExtent + u_boundsCenter;
+#else
+	vec3 local = a_position.xyz;
+#endif
+
+	mat3 rotation = rotationMatrix(u_rotation);
+	vec3 position = rotation * (local * u_scale) + u_position;
+
+	v_position = position;
+	v_normal = normalize(rotation * decodeNormal());
+	v_uv = a_texCoords;
+	gl_Position = vec4(position, 1.0);
+}
+	)";
+
+	const char* geometryFragmentShaderSource = R"(
+#version 410 core
+
+in vec3 v_position;
+in vec3 v_normal;
+in vec2 v_uv;
+
+layout(location = 0) out vec4 o_color;
+layout(location = 1) out vec4 o_position;
+layout(location = 2) out vec4 o_normal;
+
+void main() {
+	o_color = vec4(v_uv, 0.0, 1.0);
+	o_position = vec4(v_position, 1.0);
+	o_normal = vec4(v_normal, 0.0);
+}
+	)";
+
+	if (!pool.shader.compile(geometryVertexShaderSource.c_str(), geometryFragmentShaderSource)) {
+		throw Exception("Failed to compile geometry shader");
+	}
+
+	using namespace util::literals;
+
+	pool.positionUniform = pool.shader.getUniform("u_position"_hash);
+	pool.rotationUniform = pool.shader.getUniform("u_rotation"_hash);
+	pool.scaleUniform = pool.shader.getUniform("u_scale"_hash);
+	pool.boundsCenterUniform = pool.shader.getUniform("u_boundsCenter"_hash);
+	pool.boundsExtentUniform = pool.shader.getUniform("u_boundsExtent"_hash);
+
+	pool.arena.create(layout.stride, 1 << 16);
+
+	glGenVertexArrays(2, pool.vertexArrays);
+	_setupMeshVertexArray(pool, IndexFormat::U16);
+	_setupMeshVertexArray(pool, IndexFormat::U32);
+
+	_vertexPools.push_back(std::move(created));
+	return pool;
+}
+
+void RendererGL41::_setupMeshVertexArray(VertexPoolGL& pool, IndexFormat format) {
+	glBindVertexArray(pool.vertexArrays[static_cast<kengine::usize>(format)]);
+	glBindBuffer(GL_ARRAY_BUFFER, pool.arena.buffer);
+
+	GLsizei stride = static_cast<GLsizei>(pool.layout.stride);
+
+	glEnableVertexAttribArray(0);
+	switch (pool.layout.position) {
+	case PositionFormat::Float32:
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(static_cast<kengine::usize>(pool.layout.positionOffset)));
+		break;
+	case PositionFormat::Half:
+		glVertexAttribPointer(0, 4, GL_HALF_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(static_cast<kengine::usize>(pool.layout.positionOffset)));
+		break;
+	case PositionFormat::Snorm16:
+		glVertexAttribPointer(0, 4, GL_SHORT, GL_TRUE, stride, reinterpret_cast<void*>(static_cast<kengine::usize>(pool.layout.positionOffset)));
+		break;
+	}
+
+	glEnableVertexAttribArray(1);
+	switch (pool.layout.normal) {
+	case NormalFormat::Float32:
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(static_cast<kengine::usize>(pool.layout.normalOffset)));
+		break;
+	case NormalFormat::Octahedral16:
+		glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, reinterpret_cast<void*>(static_cast<kengine::usize>(pool.layout.normalOffset)));
+		break;
+	}
+
+	glEnableVertexAttribArray(2);
+	switch (pool.layout.texCoords) {
+	case TexCoordFormat::Float32:
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(static_cast<kengine::usize>(pool.layout.texCoordsOffset)));
+		break;
+	case TexCoordFormat::Half:
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(static_cast<kengine::usize>(pool.layout.texCoordsOffset)));
+		break;
+	case TexCoordFormat::Unorm16:
+		glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, reinterpret_cast<void*>(static_cast<kengine::usize>(pool.layout.texCoordsOffset)));
+		break;
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexArenas[static_cast<kengine::usize>(format)].buffer);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void RendererGL41::_uploadVertices(MeshGL& mesh) {
+	kengine::u64 count = mesh._vertices.size();
+	if (count > mesh._vertexCapacity) {
+		VertexPoolGL& pool = mesh._pool;
+		pool.arena.free(mesh._vertexOffset, mesh._vertexCapacity);
+		if (pool.arena.allocate(count, mesh._vertexOffset)) {
+			_setupMeshVertexArray(pool, IndexFormat::U16);
+			_setupMeshVertexArray(pool, IndexFormat::U32);
+		}
+
+		mesh._vertexCapacity = count;
+	}
+
+	mesh._bounds = computeBounds(mesh._vertices);
+	if (count == 0) {
+		return;
+	}
+
+	VertexLayout const& layout = mesh._pool.layout;
+	std::vector<kengine::u8> encoded(count * layout.stride);
+	encodeVertices(mesh._vertices, layout, mesh._bounds, encoded.data());
+	mesh._pool.arena.upload(mesh._vertexOffset, encoded.data(), count);
+}
+
+void RendererGL41::_uploadIndices(MeshGL& mesh) {
+	kengine::u64 count = mesh._indices.size();
+	IndexFormat format = chooseIndexFormat(mesh._indices);
+
+	if (format != mesh._indexFormat) {
+		_indexArenas[static_cast<kengine::usize>(mesh._indexFormat)].free(mesh._indexOffset, mesh._indexCapacity);
+		mesh._indexOffset = util::RangeAllocator::invalidOffset;
+		mesh._indexCapacity = 0;
+		mesh._indexFormat = format;
+	}
+
+	BufferArenaGL& arena = _indexArenas[static_cast<kengine::usize>(format)];
+	if (count > mesh._indexCapacity) {
+		arena.free(mesh._indexOffset, mesh._indexCapacity);
+		if (arena.allocate(count, mesh._indexOffset)) {
+			for (std::unique_ptr<VertexPoolGL> const& pool : _vertexPools) {
+				_setupMeshVertexArray(*pool, format);
+			}
+		}
+
+		mesh._indexCapacity = count;
+	}
+
+	if (count == 0) {
+		return;
+	}
+
+	std::vector<kengine::u8> encoded(count * indexFormatSize(format));
+	encodeIndices(mesh._indices, format, encoded.data());
+	arena.upload(mesh._indexOffset, encoded.data(), count);
+}
+
+IMesh* RendererGL41::createMesh(VertexLayout const& layout) {
+	MeshGL* mesh = new MeshGL(*this, _getVertexPool(layout));
+	_meshes.push_back(mesh);
+	return mesh;
+}
+
+void RendererGL41::destroyMesh(IMesh* mesh) {
+	auto it = std::find(_meshes.begin(), _meshes.end(), mesh);
+	if (it == _meshes.end()) {
+		throw RendererException("RendererGL41::destroyMesh: Mesh was not created by this renderer");
+	}
+
+	MeshGL* meshGL = *it;
+	meshGL->_pool.arena.free(meshGL->_vertexOffset, meshGL->_vertexCapacity);
+	_indexArenas[static_cast<kengine::usize>(meshGL->_indexFormat)].free(meshGL->_indexOffset, meshGL->_indexCapacity);
+
+	delete meshGL;
+	_meshes.erase(it);
 }
 
 IObject* RendererGL41::createObject(IMesh* mesh) {
-	return nullptr;
+	IObject* object = new IObject(mesh);
+	_objects.push_back(object);
+	return object;
+}
+
+void MeshGL::setVertices(util::Span<Vertex const> vertices) {
+	_vertices.assign(vertices.begin(), vertices.end());
+	_renderer._uploadVertices(*this);
+}
+
+void MeshGL::setIndices(util::Span<kengine::u32 const> indices) {
+	_indices.assign(indices.begin(), indices.end());
+	_renderer._uploadIndices(*this);
 }
 
 } // namespace kengine::core::graphics::gl41
@@ -5,10 +5,18 @@
 #include <glad/glad.h>
 
 #include <vector>
+#include <memory>
+#include <unordered_map>
+#include <string_view>
+#include <cstring>
+#include <algorithm>
 
 #include <kengine/macros.hpp>
+#include <kengine/util/hash.hpp>
+#include <kengine/util/range_allocator.hpp>
 #include <kengine/util/math/vector.hpp>
 #include <kengine/core/graphics/renderer.hpp>
+#include <kengine/core/graphics/vertex_format.hpp>
 
 namespace kengine::core::graphics::gl41 {
 
@@ -68,6 +76,38 @@ struct FramebufferGL {
 	}
 };
 
+struct UniformHandle {
+	kengine::usize index = static_cast<kengine::usize>(-1);
+
+	bool isValid() const { return index != static_cast<kengine::usize>(-1); }
+};
+
+struct UniformGL {
+	kengine::u64 hash = 0;
+	GLint location = -1;
+	GLenum type = 0;
+	GLint count = 0;
+
+	// index into the shader's uniform blocks, -1 for uniforms in the default block
+	GLint block = -1;
+	// byte offset into the owning block's buffer, or into the default block storage
+	kengine::usize offset = 0;
+	kengine::usize size = 0;
+	// std140 layout of block members, 0 for uniforms that aren't arrays or matrices
+	kengine::usize arrayStride = 0;
+	kengine::usize matrixStride = 0;
+
+	bool dirty = false;
+};
+
+struct UniformBlockGL {
+	kengine::u64 hash = 0;
+	GLuint index = 0;
+	GLuint ubo = 0;
+	std::vector<kengine::u8> data;
+	bool dirty = false;
+};
+
 class ShaderGL {
 public:
 	bool compile(const char* vertexSource, const char* fragmentSource) {
@@ -81,6 +121,7 @@ public:
 			GLchar infoLog[512];
 			glGetShaderInfoLog(vertexShader, sizeof(infoLog), nullptr, infoLog);
 			Logger::get().logf(LogSeverity::Error, "Vertex shader compilation failed: {}", infoLog);
+			glDeleteShader(vertexShader);
 			return false;
 		}
 
@@ -97,62 +138,442 @@ public:
 			return false;
 		}
 
-		_program = glCreateProgram();
-		glAttachShader(_program, vertexShader);
-		glAttachShader(_program, fragmentShader);
-		glLinkProgram(_program);
+		GLuint program = glCreateProgram();
+		glAttachShader(program, vertexShader);
+		glAttachShader(program, fragmentShader);
+		glLinkProgram(program);
 
 		glDeleteShader(vertexShader);
 		glDeleteShader(fragmentShader);
 
-		glGetProgramiv(_program, GL_LINK_STATUS, &success);
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
 		if (!success) {
 			GLchar infoLog[512];
-			glGetProgramInfoLog(_program, sizeof(infoLog), nullptr, infoLog);
+			glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
 			Logger::get().logf(LogSeverity::Error, "Shader program linking failed: {}", infoLog);
-			glDeleteProgram(_program);
+			glDeleteProgram(program);
 			return false;
 		}
 
-		glDeleteShader(vertexShader);
-		glDeleteShader(fragmentShader);
+		// a recompile replaces the program only once the new one links, the old one stays usable until then
+		_release();
+		_program = program;
+		_reflect();
 		return true;
 	}
 
 	~ShaderGL() {
-		glDeleteProgram(_program);
+		_release();
 	}
 
 	void bind() const {
 		glUseProgram(_program);
+		for (UniformBlockGL const& block : _blocks) {
+			glBindBufferBase(GL_UNIFORM_BUFFER, block.index, block.ubo);
+		}
 	}
 
-	void setUniform(const char* name, const GLint& value) const {
-		glUniform1i(glGetUniformLocation(_program, name), value);
+	// uploads every uniform written since the last flush, the shader must be bound
+	void flush() {
+		for (kengine::usize index : _dirtyUniforms) {
+			UniformGL& uniform = _uniforms[index];
+			_uploadUniform(uniform);
+			uniform.dirty = false;
+		}
+		_dirtyUniforms.clear();
+
+		for (UniformBlockGL& block : _blocks) {
+			if (!block.dirty) {
+				continue;
+			}
+
+			glBindBuffer(GL_UNIFORM_BUFFER, block.ubo);
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(block.data.size()), block.data.data());
+			block.dirty = false;
+		}
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	UniformHandle getUniform(kengine::u64 nameHash) const {
+		auto it = _uniformIndices.find(nameHash);
+		if (it == _uniformIndices.end()) {
+			return UniformHandle();
+		}
+
+		return UniformHandle{ it->second };
+	}
+
+	UniformHandle getUniform(const char* name) const {
+		return getUniform(util::hash(name));
 	}
 
-	void setUniform(const char* name, const GLuint& value) const {
-		glUniform1ui(glGetUniformLocation(_program, name), value);
+	template<typename T>
+	void setUniform(kengine::u64 nameHash, T const& value) {
+		setUniform(getUniform(nameHash), value);
 	}
 
-	void setUniform(const char* name, const GLfloat& value) const {
-		glUniform1f(glGetUniformLocation(_program, name), value);
+	template<typename T>
+	void setUniform(const char* name, T const& value) {
+		setUniform(getUniform(util::hash(name)), value);
 	}
 
-	void setUniform(const char* name, const util::math::Vector<f32, 2>& vec) const {
-		glUniform2fv(glGetUniformLocation(_program, name), 1, vec.data());
+	void setUniform(UniformHandle uniform, const GLint& value) {
+		_writeUniform(uniform, &value, sizeof(value));
 	}
 
-	void setUniform(const char* name, const util::math::Vector<f32, 3>& vec) const {
-		glUniform3fv(glGetUniformLocation(_program, name), 1, vec.data());
+	void setUniform(UniformHandle uniform, const GLuint& value) {
+		_writeUniform(uniform, &value, sizeof(value));
 	}
 
-	void setUniform(const char* name, const util::math::Vector<f32, 4>& vec) const {
-		glUniform4fv(glGetUniformLocation(_program, name), 1, vec.data());
+	void setUniform(UniformHandle uniform, const GLfloat& value) {
+		_writeUniform(uniform, &value, sizeof(value));
+	}
+
+	void setUniform(UniformHandle uniform, const util::math::Vector<f32, 2>& vec) {
+		_writeUniform(uniform, vec.data(), sizeof(f32) * 2);
+	}
+
+	void setUniform(UniformHandle uniform, const util::math::Vector<f32, 3>& vec) {
+		_writeUniform(uniform, vec.data(), sizeof(f32) * 3);
+	}
+
+	void setUniform(UniformHandle uniform, const util::math::Vector<f32, 4>& vec) {
+		_writeUniform(uniform, vec.data(), sizeof(f32) * 4);
 	}
 
 private:
-	GLuint _program;
+	void _release() {
+		for (UniformBlockGL& block : _blocks) {
+			glDeleteBuffers(1, &block.ubo);
+		}
+
+		_blocks.clear();
+		glDeleteProgram(_program);
+		_program = 0;
+	}
+
+	void _reflect() {
+		_uniforms.clear();
+		_uniformIndices.clear();
+		_defaultStorage.clear();
+		_dirtyUniforms.clear();
+
+		GLint blockCount = 0;
+		glGetProgramiv(_program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+
+		GLint maxBlockNameLength = 0;
+		glGetProgramiv(_program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockNameLength);
+		std::vector<GLchar> blockName(static_cast<kengine::usize>(maxBlockNameLength) + 1);
+
+		for (GLint i = 0; i < blockCount; ++i) {
+			GLsizei length = 0;
+			glGetActiveUniformBlockName(_program, static_cast<GLuint>(i), static_cast<GLsizei>(blockName.size()), &length, blockName.data());
+
+			GLint size = 0;
+			glGetActiveUniformBlockiv(_program, static_cast<GLuint>(i), GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+
+			UniformBlockGL block;
+			block.hash = util::hash(blockName.data(), static_cast<kengine::usize>(length));
+			block.index = static_cast<GLuint>(i);
+			block.data.resize(static_cast<kengine::usize>(size), 0);
+
+			glUniformBlockBinding(_program, block.index, block.index);
+
+			glGenBuffers(1, &block.ubo);
+			glBindBuffer(GL_UNIFORM_BUFFER, block.ubo);
+			glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+
+			_blocks.push_back(std::move(block));
+		}
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		GLint uniformCount = 0;
+		glGetProgramiv(_program, GL_ACTIVE_UNIFORMS, &uniformCount);
+
+		GLint maxNameLength = 0;
+		glGetProgramiv(_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+		std::vector<GLchar> name(static_cast<kengine::usize>(maxNameLength) + 1);
+
+		for (GLint i = 0; i < uniformCount; ++i) {
+			GLuint index = static_cast<GLuint>(i);
+
+			UniformGL uniform;
+			GLsizei length = 0;
+			glGetActiveUniform(_program, index, static_cast<GLsizei>(name.size()), &length, &uniform.count, &uniform.type, name.data());
+
+			// arrays are reported as "name[0]", key them by their plain name
+			std::string_view view(name.data(), static_cast<kengine::usize>(length));
+			if (view.size() > 3 && view.substr(view.size() - 3) == "[0]") {
+				view = view.substr(0, view.size() - 3);
+			}
+
+			uniform.hash = util::hash(view);
+			uniform.size = _uniformTypeSize(uniform.type) * static_cast<kengine::usize>(uniform.count);
+
+			glGetActiveUniformsiv(_program, 1, &index, GL_UNIFORM_BLOCK_INDEX, &uniform.block);
+			if (uniform.block >= 0) {
+				GLint offset = 0;
+				glGetActiveUniformsiv(_program, 1, &index, GL_UNIFORM_OFFSET, &offset);
+				uniform.offset = static_cast<kengine::usize>(offset);
+
+				GLint arrayStride = 0;
+				glGetActiveUniformsiv(_program, 1, &index, GL_UNIFORM_ARRAY_STRIDE, &arrayStride);
+				uniform.arrayStride = static_cast<kengine::usize>(arrayStride);
+
+				GLint matrixStride = 0;
+				glGetActiveUniformsiv(_program, 1, &index, GL_UNIFORM_MATRIX_STRIDE, &matrixStride);
+				uniform.matrixStride = static_cast<kengine::usize>(matrixStride);
+			} else {
+				uniform.location = glGetUniformLocation(_program, name.data());
+				uniform.offset = _defaultStorage.size();
+				_defaultStorage.resize(_defaultStorage.size() + uniform.size, 0);
+			}
+
+			if (_uniformIndices.find(uniform.hash) != _uniformIndices.end()) {
+				Logger::get().logf(LogSeverity::Warning, "Shader uniform {} collides with another uniform's name hash", std::string(view));
+				continue;
+			}
+
+			_uniformIndices[uniform.hash] = _uniforms.size();
+			_uniforms.push_back(uniform);
+		}
+	}
+
+	void _writeUniform(UniformHandle handle, const void* value, kengine::usize size) {
+		if (!handle.isValid()) {
+			return;
+		}
+
+		UniformGL& uniform = _uniforms[handle.index];
+		if (size > uniform.size) {
+			Logger::get().logf(LogSeverity::Warning, "Shader uniform write of {} bytes exceeds uniform size of {} bytes", size, uniform.size);
+			return;
+		}
+
+		if (uniform.block >= 0) {
+			UniformBlockGL& block = _blocks[static_cast<kengine::usize>(uniform.block)];
+			_writeBlockUniform(block.data.data() + uniform.offset, uniform, static_cast<const kengine::u8*>(value), size);
+			block.dirty = true;
+			return;
+		}
+
+		std::memcpy(_defaultStorage.data() + uniform.offset, value, size);
+		if (!uniform.dirty) {
+			uniform.dirty = true;
+			_dirtyUniforms.push_back(handle.index);
+		}
+	}
+
+	// values come in tightly packed, std140 pads array elements and matrix columns to their strides
+	static void _writeBlockUniform(kengine::u8* out, UniformGL const& uniform, const kengine::u8* value, kengine::usize size) {
+		kengine::usize elementSize = _uniformTypeSize(uniform.type);
+		kengine::usize columns = _uniformMatrixColumns(uniform.type);
+
+		for (kengine::usize packed = 0, element = 0; packed < size; packed += elementSize, ++element) {
+			kengine::u8* elementOut = out + element * uniform.arrayStride;
+			kengine::usize elementBytes = std::min(elementSize, size - packed);
+			if (columns == 0) {
+				std::memcpy(elementOut, value + packed, elementBytes);
+				continue;
+			}
+
+			kengine::usize columnSize = elementSize / columns;
+			for (kengine::usize column = 0; column * columnSize < elementBytes; ++column) {
+				kengine::usize columnBytes = std::min(columnSize, elementBytes - column * columnSize);
+				std::memcpy(elementOut + column * uniform.matrixStride, value + packed + column * columnSize, columnBytes);
+			}
+		}
+	}
+
+	void _uploadUniform(UniformGL const& uniform) const {
+		const void* data = _defaultStorage.data() + uniform.offset;
+		const GLfloat* f = static_cast<const GLfloat*>(data);
+		const GLint* i = static_cast<const GLint*>(data);
+		const GLuint* u = static_cast<const GLuint*>(data);
+
+		switch (uniform.type) {
+		case GL_FLOAT: glUniform1fv(uniform.location, uniform.count, f); break;
+		case GL_FLOAT_VEC2: glUniform2fv(uniform.location, uniform.count, f); break;
+		case GL_FLOAT_VEC3: glUniform3fv(uniform.location, uniform.count, f); break;
+		case GL_FLOAT_VEC4: glUniform4fv(uniform.location, uniform.count, f); break;
+		case GL_FLOAT_MAT2: glUniformMatrix2fv(uniform.location, uniform.count, GL_FALSE, f); break;
+		case GL_FLOAT_MAT3: glUniformMatrix3fv(uniform.location, uniform.count, GL_FALSE, f); break;
+		case GL_FLOAT_MAT4: glUniformMatrix4fv(uniform.location, uniform.count, GL_FALSE, f); break;
+		case GL_INT_VEC2: glUniform2iv(uniform.location, uniform.count, i); break;
+		case GL_INT_VEC3: glUniform3iv(uniform.location, uniform.count, i); break;
+		case GL_INT_VEC4: glUniform4iv(uniform.location, uniform.count, i); break;
+		case GL_UNSIGNED_INT: glUniform1uiv(uniform.location, uniform.count, u); break;
+		case GL_UNSIGNED_INT_VEC2: glUniform2uiv(uniform.location, uniform.count, u); break;
+		case GL_UNSIGNED_INT_VEC3: glUniform3uiv(uniform.location, uniform.count, u); break;
+		case GL_UNSIGNED_INT_VEC4: glUniform4uiv(uniform.location, uniform.count, u); break;
+		// ints, bools and samplers
+		default: glUniform1iv(uniform.location, uniform.count, i); break;
+		}
+	}
+
+	static kengine::usize _uniformTypeSize(GLenum type) {
+		switch (type) {
+		case GL_FLOAT_VEC2:
+		case GL_INT_VEC2:
+		case GL_UNSIGNED_INT_VEC2:
+			return 8;
+		case GL_FLOAT_VEC3:
+		case GL_INT_VEC3:
+		case GL_UNSIGNED_INT_VEC3:
+			return 12;
+		case GL_FLOAT_VEC4:
+		case GL_INT_VEC4:
+		case GL_UNSIGNED_INT_VEC4:
+		case GL_FLOAT_MAT2:
+			return 16;
+		case GL_FLOAT_MAT3:
+			return 36;
+		case GL_FLOAT_MAT4:
+			return 64;
+		default:
+			return 4;
+		}
+	}
+
+	static kengine::usize _uniformMatrixColumns(GLenum type) {
+		switch (type) {
+		case GL_FLOAT_MAT2:
+			return 2;
+		case GL_FLOAT_MAT3:
+			return 3;
+		case GL_FLOAT_MAT4:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	GLuint _program = 0;
+
+	std::vector<UniformGL> _uniforms;
+	std::vector<UniformBlockGL> _blocks;
+	std::unordered_map<kengine::u64, kengine::usize> _uniformIndices;
+
+	std::vector<kengine::u8> _defaultStorage;
+	std::vector<kengine::usize> _dirtyUniforms;
+};
+
+// one GL buffer sub-allocated into element ranges, grown by copying when a range doesn't fit
+struct BufferArenaGL {
+	GLuint buffer = 0;
+	kengine::usize elementSize = 0;
+	util::RangeAllocator allocator;
+
+	~BufferArenaGL() {
+		glDeleteBuffers(1, &buffer);
+	}
+
+	void create(kengine::usize bytesPerElement, kengine::u64 capacity) {
+		elementSize = bytesPerElement;
+
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(capacity * elementSize), nullptr, GL_STATIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		allocator.reset(capacity);
+	}
+
+	// returns true when the buffer had to be reallocated, anything referencing the old buffer name must be rebound
+	bool allocate(kengine::u64 count, kengine::u64& offset) {
+		offset = allocator.allocate(count);
+		if (offset != util::RangeAllocator::invalidOffset) {
+			return false;
+		}
+
+		kengine::u64 capacity = allocator.getCapacity();
+		kengine::u64 grownCapacity = std::max(capacity * 2, capacity + count);
+
+		GLuint grown = 0;
+		glGenBuffers(1, &grown);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+		glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(grownCapacity * elementSize), nullptr, GL_STATIC_DRAW);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(capacity * elementSize));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		glDeleteBuffers(1, &buffer);
+		buffer = grown;
+
+		allocator.grow(grownCapacity);
+		offset = allocator.allocate(count);
+		return true;
+	}
+
+	void free(kengine::u64 offset, kengine::u64 count) {
+		allocator.free(offset, count);
+	}
+
+	void upload(kengine::u64 offset, const void* data, kengine::u64 count) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset * elementSize), static_cast<GLsizeiptr>(count * elementSize), data);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+};
+
+// meshes sharing a vertex layout share a vertex arena, its vertex arrays and the shader variant decoding it
+struct VertexPoolGL {
+	VertexLayout layout;
+	BufferArenaGL arena;
+	// one vertex array per IndexFormat, the element buffer binding is vertex array state
+	GLuint vertexArrays[2] = { 0 };
+
+	ShaderGL shader;
+	UniformHandle positionUniform;
+	UniformHandle rotationUniform;
+	UniformHandle scaleUniform;
+	UniformHandle boundsCenterUniform;
+	UniformHandle boundsExtentUniform;
+
+	~VertexPoolGL() {
+		glDeleteVertexArrays(2, vertexArrays);
+	}
+};
+
+class RendererGL41;
+
+// keeps a CPU copy for getVertices()/getIndices(), GPU data lives in ranges of the renderer's shared arenas
+class MeshGL : public IMesh {
+public:
+	MeshGL(RendererGL41& renderer, VertexPoolGL& pool) : _renderer(renderer), _pool(pool) {}
+	~MeshGL() override = default;
+
+	util::Span<Vertex const> getVertices() const override { return _vertices; }
+	void setVertices(util::Span<Vertex const> vertices) override;
+
+	util::Span<kengine::u32 const> getIndices() const override { return _indices; }
+	void setIndices(util::Span<kengine::u32 const> indices) override;
+
+	kengine::u64 getBaseVertex() const { return _vertexOffset; }
+	kengine::u64 getFirstIndex() const { return _indexOffset; }
+	kengine::u64 getIndexCount() const { return _indices.size(); }
+	IndexFormat getIndexFormat() const { return _indexFormat; }
+	VertexLayout const& getVertexLayout() const { return _pool.layout; }
+	MeshBounds const& getBounds() const { return _bounds; }
+
+private:
+	RendererGL41& _renderer;
+	VertexPoolGL& _pool;
+
+	std::vector<Vertex> _vertices;
+	std::vector<kengine::u32> _indices;
+
+	MeshBounds _bounds;
+	IndexFormat _indexFormat = IndexFormat::U16;
+
+	kengine::u64 _vertexOffset = util::RangeAllocator::invalidOffset;
+	kengine::u64 _vertexCapacity = 0;
+	kengine::u64 _indexOffset = util::RangeAllocator::invalidOffset;
+	kengine::u64 _indexCapacity = 0;
+
+	friend class RendererGL41;
 };
 
 class RendererGL41 : public IRenderer {
@@ -161,19 +582,47 @@ public:
 	~RendererGL41();
 
 	void render() override;
-	IMesh* createMesh() override;
+	void submit(CommandBuffer const& commands) override;
+
+	using IRenderer::createMesh;
+	IMesh* createMesh(VertexLayout const& layout) override;
+	void destroyMesh(IMesh* mesh) override;
 	IObject* createObject(IMesh* mesh) override;
 
 private:
+	friend class MeshGL;
+
 	void _initGL();
 	void _deinitGL();
 	void _swapBuffers();
 
+	void _execute(CommandPacket const& packet);
+	void _applyState(kengine::u32 state);
+	void _draw(DrawCommand const& command);
+
+	VertexPoolGL& _getVertexPool(VertexLayout const& layout);
+	void _setupMeshVertexArray(VertexPoolGL& pool, IndexFormat format);
+	void _uploadVertices(MeshGL& mesh);
+	void _uploadIndices(MeshGL& mesh);
+
 	window::IWindow& _window;
 	FramebufferGL<3> _intermediateFramebuffers[2];
 
 	ShaderGL _litShader;
 
+	// created on first use of a layout, so only layouts in use cost a shader and buffers
+	std::vector<std::unique_ptr<VertexPoolGL>> _vertexPools;
+	// one arena per IndexFormat, shared by every vertex pool
+	BufferArenaGL _indexArenas[2];
+	VertexPoolGL* _boundPool = nullptr;
+	IndexFormat _boundIndexFormat = IndexFormat::U16;
+
+	std::vector<MeshGL*> _meshes;
+	std::vector<IObject*> _objects;
+
+	CommandQueue _commands;
+	kengine::u32 _state = StateDepthWrite;
+
 #ifdef KENGINE_PLATFORM_WINDOWS
 	HDC _hdc = nullptr;
 	HGLRC _hglrc = nullptr;
@@ -0,0 +1,414 @@
+#include <kengine/core/graphics/mesh_optimizer.hpp>
+#include <kengine/core/exception.hpp>
+#include <kengine/core/logging.hpp>
+#include <kengine/util/hash.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace kengine::core::graphics {
+
+namespace {
+
+constexpr kengine::u32 invalidIndex = static_cast<kengine::u32>(-1);
+
+constexpr kengine::u32 forsythCacheSize = 32;
+constexpr kengine::f32 forsythLastTriangleScore = 0.75f;
+constexpr kengine::f32 forsythCacheDecayPower = 1.5f;
+constexpr kengine::f32 forsythValenceBoostScale = 2.0f;
+constexpr kengine::f32 forsythValenceBoostPower = 0.5f;
+
+kengine::f32 forsythVertexScore(kengine::s32 cachePosition, kengine::u32 remainingTriangles) {
+	if (remainingTriangles == 0) {
+		return -1.0f;
+	}
+
+	kengine::f32 score = 0.0f;
+	if (cachePosition >= 0) {
+		if (cachePosition < 3) {
+			// the last triangle's vertices get a fixed score so it isn't trivially re-picked
+			score = forsythLastTriangleScore;
+		} else {
+			kengine::f32 scaler = 1.0f / static_cast<kengine::f32>(forsythCacheSize - 3);
+			score = std::pow(1.0f - static_cast<kengine::f32>(cachePosition - 3) * scaler, forsythCacheDecayPower);
+		}
+	}
+
+	score += forsythValenceBoostScale * std::pow(static_cast<kengine::f32>(remainingTriangles), -forsythValenceBoostPower);
+	return score;
+}
+
+struct VertexHasher {
+	kengine::usize operator()(Vertex const* vertex) const {
+		return static_cast<kengine::usize>(util::hash(reinterpret_cast<const char*>(vertex), sizeof(Vertex)));
+	}
+};
+
+struct VertexEqual {
+	bool operator()(Vertex const* a, Vertex const* b) const {
+		return std::memcmp(a, b, sizeof(Vertex)) == 0;
+	}
+};
+
+util::math::Vector<f32, 3> cross(util::math::Vector<f32, 3> const& a, util::math::Vector<f32, 3> const& b) {
+	return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+}
+
+// every stage indexes per-vertex arrays with the raw indices, an out of range one is caught here instead
+bool indicesInRange(util::Span<kengine::u32 const> indices, kengine::usize vertexCount, char const* stage) {
+	for (kengine::usize i = 0; i < indices.size(); ++i) {
+		if (indices[i] >= vertexCount) {
+			KENGINE_LOG(Graphics, Error, "{}: index {} at {} is out of range for {} vertices, skipping", stage, indices[i], i, vertexCount);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
+kengine::f32 computeACMR(util::Span<kengine::u32 const> indices, kengine::usize vertexCount, kengine::u32 cacheSize) {
+	kengine::usize triangleCount = indices.size() / 3;
+	if (triangleCount == 0 || !indicesInRange(indices, vertexCount, "computeACMR")) {
+		return 0.0f;
+	}
+
+	// a vertex is in the FIFO if it was inserted within the last cacheSize insertions
+	std::vector<kengine::usize> insertedAt(vertexCount, 0);
+	kengine::usize timestamp = cacheSize + 1;
+	kengine::usize misses = 0;
+
+	for (kengine::u32 index : indices) {
+		if (timestamp - insertedAt[index] > cacheSize) {
+			insertedAt[index] = timestamp++;
+			++misses;
+		}
+	}
+
+	return static_cast<kengine::f32>(misses) / static_cast<kengine::f32>(triangleCount);
+}
+
+kengine::usize weldVertices(MeshData& mesh) {
+	kengine::usize vertexCount = mesh.vertices.size();
+	if (!indicesInRange(mesh.indices, vertexCount, "weldVertices")) {
+		return 0;
+	}
+
+	std::unordered_map<Vertex const*, kengine::u32, VertexHasher, VertexEqual> unique;
+	unique.reserve(vertexCount);
+
+	std::vector<kengine::u32> remap(vertexCount);
+	std::vector<Vertex> vertices;
+	vertices.reserve(vertexCount);
+
+	for (kengine::usize i = 0; i < vertexCount; ++i) {
+		auto [it, inserted] = unique.emplace(&mesh.vertices[i], static_cast<kengine::u32>(vertices.size()));
+		if (inserted) {
+			vertices.push_back(mesh.vertices[i]);
+		}
+
+		remap[i] = it->second;
+	}
+
+	for (kengine::u32& index : mesh.indices) {
+		index = remap[index];
+	}
+
+	kengine::usize removed = vertexCount - vertices.size();
+	mesh.vertices = std::move(vertices);
+	return removed;
+}
+
+void optimizeVertexCache(util::Span<kengine::u32> indices, kengine::usize vertexCount) {
+	kengine::usize triangleCount = indices.size() / 3;
+	if (triangleCount == 0 || !indicesInRange(indices, vertexCount, "optimizeVertexCache")) {
+		return;
+	}
+
+	// vertex -> triangle adjacency, the live range of each list shrinks as triangles are emitted
+	std::vector<kengine::u32> remaining(vertexCount, 0);
+	for (kengine::usize i = 0; i < triangleCount * 3; ++i) {
+		++remaining[indices[i]];
+	}
+
+	std::vector<kengine::u32> offsets(vertexCount + 1, 0);
+	for (kengine::usize i = 0; i < vertexCount; ++i) {
+		offsets[i + 1] = offsets[i] + remaining[i];
+	}
+
+	std::vector<kengine::u32> adjacency(triangleCount * 3);
+	std::vector<kengine::u32> cursor(offsets.begin(), offsets.end() - 1);
+	for (kengine::usize i = 0; i < triangleCount * 3; ++i) {
+		adjacency[cursor[indices[i]]++] = static_cast<kengine::u32>(i / 3);
+	}
+
+	std::vector<kengine::s32> cachePositions(vertexCount, -1);
+	std::vector<kengine::f32> vertexScores(vertexCount);
+	for (kengine::usize i = 0; i < vertexCount; ++i) {
+		vertexScores[i] = forsythVertexScore(-1, remaining[i]);
+	}
+
+	std::vector<kengine::f32> triangleScores(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+
+	kengine::u32 best = 0;
+	for (kengine::usize t = 0; t < triangleCount; ++t) {
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		if (triangleScores[t] > triangleScores[best]) {
+			best = static_cast<kengine::u32>(t);
+		}
+	}
+
+	std::vector<kengine::u32> output;
+	output.reserve(triangleCount * 3);
+
+	std::vector<kengine::u32> cache;
+	std::vector<kengine::u32> nextCache;
+	cache.reserve(forsythCacheSize + 3);
+	nextCache.reserve(forsythCacheSize + 3);
+
+	kengine::usize scan = 0;
+	while (best != invalidIndex) {
+		kengine::u32 const* triangle = &indices[best * 3];
+		output.insert(output.end(), triangle, triangle + 3);
+		emitted[best] = true;
+
+		for (kengine::usize k = 0; k < 3; ++k) {
+			kengine::u32 vertex = triangle[k];
+			kengine::u32* begin = &adjacency[offsets[vertex]];
+			kengine::u32* end = begin + remaining[vertex];
+			kengine::u32* found = std::find(begin, end, best);
+			if (found != end) {
+				std::swap(*found, *(end - 1));
+				--remaining[vertex];
+			}
+		}
+
+		nextCache.assign(triangle, triangle + 3);
+		for (kengine::u32 vertex : cache) {
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]) {
+				nextCache.push_back(vertex);
+			}
+		}
+
+		// rescore everything that entered, moved within or fell out of the cache
+		for (kengine::usize i = 0; i < nextCache.size(); ++i) {
+			kengine::u32 vertex = nextCache[i];
+			cachePositions[vertex] = i < forsythCacheSize ? static_cast<kengine::s32>(i) : -1;
+
+			kengine::f32 score = forsythVertexScore(cachePositions[vertex], remaining[vertex]);
+			kengine::f32 delta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+
+			for (kengine::u32 j = 0; j < remaining[vertex]; ++j) {
+				triangleScores[adjacency[offsets[vertex] + j]] += delta;
+			}
+		}
+
+		if (nextCache.size() > forsythCacheSize) {
+			nextCache.resize(forsythCacheSize);
+		}
+		std::swap(cache, nextCache);
+
+		best = invalidIndex;
+		kengine::f32 bestScore = -1.0f;
+		for (kengine::u32 vertex : cache) {
+			for (kengine::u32 j = 0; j < remaining[vertex]; ++j) {
+				kengine::u32 candidate = adjacency[offsets[vertex] + j];
+				if (triangleScores[candidate] > bestScore) {
+					bestScore = triangleScores[candidate];
+					best = candidate;
+				}
+			}
+		}
+
+		// nothing adjacent to the cache is left, restart from the next unemitted triangle
+		if (best == invalidIndex) {
+			while (scan < triangleCount && emitted[scan]) {
+				++scan;
+			}
+
+			if (scan < triangleCount) {
+				best = static_cast<kengine::u32>(scan);
+			}
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void optimizeOverdraw(util::Span<kengine::u32> indices, util::Span<Vertex const> vertices, kengine::f32 threshold, kengine::u32 cacheSize) {
+	kengine::usize triangleCount = indices.size() / 3;
+	if (triangleCount < 2 || vertices.empty() || !indicesInRange(indices, vertices.size(), "optimizeOverdraw")) {
+		return;
+	}
+
+	kengine::f32 baseAcmr = computeACMR(indices, vertices.size(), cacheSize);
+
+	// a triangle missing the cache on all three vertices is a natural restart point of the cache optimized order
+	std::vector<kengine::u32> clusterStarts;
+	std::vector<kengine::usize> insertedAt(vertices.size(), 0);
+	kengine::usize timestamp = cacheSize + 1;
+	for (kengine::usize t = 0; t < triangleCount; ++t) {
+		kengine::u32 misses = 0;
+		for (kengine::usize k = 0; k < 3; ++k) {
+			kengine::u32 index = indices[t * 3 + k];
+			if (timestamp - insertedAt[index] > cacheSize) {
+				insertedAt[index] = timestamp++;
+				++misses;
+			}
+		}
+
+		if (t == 0 || misses == 3) {
+			clusterStarts.push_back(static_cast<kengine::u32>(t));
+		}
+	}
+
+	if (clusterStarts.size() < 2) {
+		return;
+	}
+	clusterStarts.push_back(static_cast<kengine::u32>(triangleCount));
+
+	util::math::Vector<f32, 3> meshCentroid;
+	for (Vertex const& vertex : vertices) {
+		meshCentroid += vertex.position;
+	}
+	meshCentroid /= static_cast<kengine::f32>(vertices.size());
+
+	kengine::usize clusterCount = clusterStarts.size() - 1;
+	std::vector<kengine::f32> sortKeys(clusterCount);
+	for (kengine::usize c = 0; c < clusterCount; ++c) {
+		util::math::Vector<f32, 3> centroid;
+		util::math::Vector<f32, 3> normal;
+		kengine::f32 area = 0.0f;
+
+		for (kengine::u32 t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+			util::math::Vector<f32, 3> const& a = vertices[indices[t * 3]].position;
+			util::math::Vector<f32, 3> const& b = vertices[indices[t * 3 + 1]].position;
+			util::math::Vector<f32, 3> const& d = vertices[indices[t * 3 + 2]].position;
+
+			// the cross product's length is twice the area, so summing it weights by area
+			util::math::Vector<f32, 3> weightedNormal = cross(b - a, d - a);
+			kengine::f32 weight = std::sqrt(weightedNormal.dot(weightedNormal));
+
+			centroid += (a + b + d) * (weight / 3.0f);
+			normal += weightedNormal;
+			area += weight;
+		}
+
+		if (area > 0.0f) {
+			centroid /= area;
+		}
+
+		kengine::f32 normalLength = std::sqrt(normal.dot(normal));
+		if (normalLength > 0.0f) {
+			normal /= normalLength;
+		}
+
+		sortKeys[c] = (centroid - meshCentroid).dot(normal);
+	}
+
+	std::vector<kengine::u32> order(clusterCount);
+	for (kengine::usize c = 0; c < clusterCount; ++c) {
+		order[c] = static_cast<kengine::u32>(c);
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&](kengine::u32 a, kengine::u32 b) {
+		return sortKeys[a] > sortKeys[b];
+	});
+
+	std::vector<kengine::u32> reordered;
+	reordered.reserve(indices.size());
+	for (kengine::u32 c : order) {
+		reordered.insert(reordered.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+	}
+
+	if (computeACMR(reordered, vertices.size(), cacheSize) > baseAcmr * threshold) {
+		return;
+	}
+
+	std::copy(reordered.begin(), reordered.end(), indices.begin());
+}
+
+void optimizeVertexFetch(MeshData& mesh) {
+	if (!indicesInRange(mesh.indices, mesh.vertices.size(), "optimizeVertexFetch")) {
+		return;
+	}
+
+	std::vector<kengine::u32> remap(mesh.vertices.size(), invalidIndex);
+	kengine::u32 next = 0;
+
+	for (kengine::u32& index : mesh.indices) {
+		if (remap[index] == invalidIndex) {
+			remap[index] = next++;
+		}
+
+		index = remap[index];
+	}
+
+	std::vector<Vertex> vertices(next);
+	for (kengine::usize i = 0; i < mesh.vertices.size(); ++i) {
+		if (remap[i] != invalidIndex) {
+			vertices[remap[i]] = mesh.vertices[i];
+		}
+	}
+
+	mesh.vertices = std::move(vertices);
+}
+
+MeshOptimizationStats optimizeMesh(MeshData& mesh) {
+	MeshLOD whole = { 0, static_cast<kengine::u32>(mesh.indices.size()), 0.0f };
+	return optimizeMesh(mesh, util::Span<MeshLOD const>(&whole, 1));
+}
+
+MeshOptimizationStats optimizeMesh(MeshData& mesh, util::Span<MeshLOD const> lods) {
+	if (lods.empty()) {
+		return optimizeMesh(mesh);
+	}
+
+	for (MeshLOD const& lod : lods) {
+		if (static_cast<kengine::usize>(lod.firstIndex) + lod.indexCount > mesh.indices.size() || lod.indexCount % 3 != 0) {
+			throw Exception("optimizeMesh: LOD range {} + {} is not a triangle list within the {} indices", lod.firstIndex, lod.indexCount, mesh.indices.size());
+		}
+	}
+
+	MeshLOD const& base = lods[0];
+
+	MeshOptimizationStats stats;
+	stats.vertexCountBefore = mesh.vertices.size();
+	stats.acmrBefore = computeACMR(util::Span<kengine::u32 const>(mesh.indices.data() + base.firstIndex, base.indexCount), mesh.vertices.size());
+
+	// welding and vertex fetch remap the whole index buffer, the ranges keep their place and size
+	weldVertices(mesh);
+	for (MeshLOD const& lod : lods) {
+		util::Span<kengine::u32> range(mesh.indices.data() + lod.firstIndex, lod.indexCount);
+		optimizeVertexCache(range, mesh.vertices.size());
+		optimizeOverdraw(range, mesh.vertices);
+	}
+	optimizeVertexFetch(mesh);
+
+	stats.vertexCountAfter = mesh.vertices.size();
+	stats.acmrAfter = computeACMR(util::Span<kengine::u32 const>(mesh.indices.data() + base.firstIndex, base.indexCount), mesh.vertices.size());
+	return stats;
+}
+
+MeshOptimizationStats optimizeMesh(IMesh& mesh) {
+	util::Span<Vertex const> vertices = mesh.getVertices();
+	util::Span<kengine::u32 const> indices = mesh.getIndices();
+
+	MeshData data;
+	data.vertices.assign(vertices.begin(), vertices.end());
+	data.indices.assign(indices.begin(), indices.end());
+
+	MeshOptimizationStats stats = mesh.getLODs().empty() ? optimizeMesh(data) : optimizeMesh(data, mesh.getLODs());
+	mesh.setVertices(data.vertices);
+	mesh.setIndices(data.indices);
+
+	KENGINE_LOG(Graphics, Verbose, "Mesh optimized: ACMR {} -> {}, vertices {} -> {}", stats.acmrBefore, stats.acmrAfter, stats.vertexCountBefore, stats.vertexCountAfter);
+	return stats;
+}
+
+} // namespace kengine::core::graphics
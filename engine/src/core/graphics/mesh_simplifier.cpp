@@ -0,0 +1,354 @@
+#include <kengine/core/graphics/mesh_simplifier.hpp>
+#include <kengine/core/jobs/parallel.hpp>
+#include <kengine/util/hash.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace kengine::core::graphics {
+
+namespace {
+
+// symmetric 4x4 matrix accumulating squared distances to a set of planes
+struct Quadric {
+	kengine::f64 a2 = 0, ab = 0, ac = 0, ad = 0;
+	kengine::f64 b2 = 0, bc = 0, bd = 0;
+	kengine::f64 c2 = 0, cd = 0;
+	kengine::f64 d2 = 0;
+
+	void addPlane(kengine::f64 a, kengine::f64 b, kengine::f64 c, kengine::f64 d) {
+		a2 += a * a; ab += a * b; ac += a * c; ad += a * d;
+		b2 += b * b; bc += b * c; bd += b * d;
+		c2 += c * c; cd += c * d;
+		d2 += d * d;
+	}
+
+	void add(Quadric const& other) {
+		a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+		b2 += other.b2; bc += other.bc; bd += other.bd;
+		c2 += other.c2; cd += other.cd;
+		d2 += other.d2;
+	}
+
+	kengine::f64 evaluate(util::math::Vector<f32, 3> const& p) const {
+		kengine::f64 x = p[0];
+		kengine::f64 y = p[1];
+		kengine::f64 z = p[2];
+
+		return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+			+ b2 * y * y + 2 * bc * y * z + 2 * bd * y
+			+ c2 * z * z + 2 * cd * z
+			+ d2;
+	}
+};
+
+struct Collapse {
+	kengine::u32 from;
+	kengine::u32 to;
+	kengine::f64 cost;
+};
+
+struct PositionHasher {
+	kengine::usize operator()(util::math::Vector<f32, 3> const* position) const {
+		return static_cast<kengine::usize>(util::hash(reinterpret_cast<const char*>(position->data()), sizeof(f32) * 3));
+	}
+};
+
+struct PositionEqual {
+	bool operator()(util::math::Vector<f32, 3> const* a, util::math::Vector<f32, 3> const* b) const {
+		return std::memcmp(a->data(), b->data(), sizeof(f32) * 3) == 0;
+	}
+};
+
+kengine::u64 edgeKey(kengine::u32 a, kengine::u32 b) {
+	if (a > b) {
+		std::swap(a, b);
+	}
+
+	return (static_cast<kengine::u64>(a) << 32) | b;
+}
+
+util::math::Vector<f32, 3> triangleNormal(util::math::Vector<f32, 3> const& a, util::math::Vector<f32, 3> const& b, util::math::Vector<f32, 3> const& c) {
+	util::math::Vector<f32, 3> u = b - a;
+	util::math::Vector<f32, 3> v = c - a;
+	return { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+}
+
+// rejects collapses that would turn any surviving triangle around `from` upside down
+bool collapseFlips(Collapse const& collapse, util::Span<Vertex const> vertices, std::vector<kengine::u32> const& indices, std::vector<kengine::u32> const& offsets, std::vector<kengine::u32> const& adjacency) {
+	for (kengine::u32 i = offsets[collapse.from]; i < offsets[collapse.from + 1]; ++i) {
+		kengine::u32 const* triangle = &indices[adjacency[i] * 3];
+		if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+			continue;
+		}
+
+		util::math::Vector<f32, 3> positions[3];
+		for (kengine::usize k = 0; k < 3; ++k) {
+			positions[k] = vertices[triangle[k]].position;
+		}
+		util::math::Vector<f32, 3> before = triangleNormal(positions[0], positions[1], positions[2]);
+
+		for (kengine::usize k = 0; k < 3; ++k) {
+			if (triangle[k] == collapse.from) {
+				positions[k] = vertices[collapse.to].position;
+			}
+		}
+		util::math::Vector<f32, 3> after = triangleNormal(positions[0], positions[1], positions[2]);
+
+		if (before.dot(after) <= 0.0f) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+} // namespace
+
+std::vector<kengine::u32> simplifyMesh(util::Span<Vertex const> vertices, util::Span<kengine::u32 const> indices, kengine::usize targetIndexCount, kengine::f32 targetError, kengine::f32* resultError) {
+	std::vector<kengine::u32> result(indices.begin(), indices.end());
+	kengine::usize vertexCount = vertices.size();
+
+	if (resultError != nullptr) {
+		*resultError = 0.0f;
+	}
+
+	if (result.size() <= targetIndexCount || vertexCount == 0) {
+		return result;
+	}
+
+	std::vector<bool> locked(vertexCount, false);
+
+	// vertices split along an attribute seam share a position with another vertex
+	std::unordered_map<util::math::Vector<f32, 3> const*, kengine::u32, PositionHasher, PositionEqual> positions;
+	positions.reserve(vertexCount);
+	for (kengine::u32 i = 0; i < vertexCount; ++i) {
+		auto [it, inserted] = positions.emplace(&vertices[i].position, i);
+		if (!inserted) {
+			locked[i] = true;
+			locked[it->second] = true;
+		}
+	}
+
+	// border edges belong to a single triangle
+	std::unordered_map<kengine::u64, kengine::u32> edgeUses;
+	edgeUses.reserve(result.size());
+	for (kengine::usize t = 0; t < result.size() / 3; ++t) {
+		for (kengine::usize k = 0; k < 3; ++k) {
+			++edgeUses[edgeKey(result[t * 3 + k], result[t * 3 + (k + 1) % 3])];
+		}
+	}
+
+	for (auto const& [key, uses] : edgeUses) {
+		if (uses == 1) {
+			locked[static_cast<kengine::u32>(key >> 32)] = true;
+			locked[static_cast<kengine::u32>(key & 0xFFFFFFFF)] = true;
+		}
+	}
+
+	std::vector<Quadric> quadrics(vertexCount);
+	for (kengine::usize t = 0; t < result.size() / 3; ++t) {
+		util::math::Vector<f32, 3> const& p0 = vertices[result[t * 3]].position;
+		util::math::Vector<f32, 3> normal = triangleNormal(p0, vertices[result[t * 3 + 1]].position, vertices[result[t * 3 + 2]].position);
+
+		kengine::f64 length = std::sqrt(static_cast<kengine::f64>(normal.dot(normal)));
+		if (length <= 0.0) {
+			continue;
+		}
+
+		kengine::f64 a = normal[0] / length;
+		kengine::f64 b = normal[1] / length;
+		kengine::f64 c = normal[2] / length;
+		kengine::f64 d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+
+		for (kengine::usize k = 0; k < 3; ++k) {
+			quadrics[result[t * 3 + k]].addPlane(a, b, c, d);
+		}
+	}
+
+	kengine::f64 maxCost = static_cast<kengine::f64>(targetError) * static_cast<kengine::f64>(targetError);
+	kengine::f64 appliedCost = 0.0;
+
+	std::vector<kengine::u32> remap(vertexCount);
+	std::iota(remap.begin(), remap.end(), 0);
+
+	std::vector<bool> touched(vertexCount);
+	std::vector<Collapse> collapses;
+	std::vector<kengine::u32> offsets(vertexCount + 1);
+	std::vector<kengine::u32> adjacency;
+
+	// each pass applies the cheapest independent collapses, then rewrites the index buffer
+	while (result.size() > targetIndexCount) {
+		kengine::usize triangleCount = result.size() / 3;
+
+		collapses.clear();
+		for (kengine::usize t = 0; t < triangleCount; ++t) {
+			for (kengine::usize k = 0; k < 3; ++k) {
+				kengine::u32 a = result[t * 3 + k];
+				kengine::u32 b = result[t * 3 + (k + 1) % 3];
+
+				// interior edges are seen once from each side, keep one
+				if (a > b || (locked[a] && locked[b])) {
+					continue;
+				}
+
+				Quadric quadric = quadrics[a];
+				quadric.add(quadrics[b]);
+
+				kengine::f64 costToB = locked[a] ? std::numeric_limits<kengine::f64>::max() : quadric.evaluate(vertices[b].position);
+				kengine::f64 costToA = locked[b] ? std::numeric_limits<kengine::f64>::max() : quadric.evaluate(vertices[a].position);
+
+				if (costToB <= costToA) {
+					collapses.push_back({ a, b, costToB });
+				} else {
+					collapses.push_back({ b, a, costToA });
+				}
+			}
+		}
+
+		if (collapses.empty()) {
+			break;
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](Collapse const& x, Collapse const& y) {
+			return x.cost < y.cost;
+		});
+
+		std::fill(offsets.begin(), offsets.end(), 0);
+		for (kengine::u32 index : result) {
+			++offsets[index + 1];
+		}
+		for (kengine::usize i = 0; i < vertexCount; ++i) {
+			offsets[i + 1] += offsets[i];
+		}
+
+		adjacency.resize(result.size());
+		std::vector<kengine::u32> cursor(offsets.begin(), offsets.end() - 1);
+		for (kengine::usize i = 0; i < result.size(); ++i) {
+			adjacency[cursor[result[i]]++] = static_cast<kengine::u32>(i / 3);
+		}
+
+		std::fill(touched.begin(), touched.end(), false);
+
+		kengine::usize remainingIndices = result.size();
+		kengine::usize applied = 0;
+
+		for (Collapse const& collapse : collapses) {
+			if (collapse.cost > maxCost || remainingIndices <= targetIndexCount) {
+				break;
+			}
+
+			if (touched[collapse.from] || touched[collapse.to]) {
+				continue;
+			}
+
+			if (collapseFlips(collapse, vertices, result, offsets, adjacency)) {
+				continue;
+			}
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to].add(quadrics[collapse.from]);
+
+			// everything sharing a triangle with `from` changes shape, keep it out of this pass
+			for (kengine::u32 i = offsets[collapse.from]; i < offsets[collapse.from + 1]; ++i) {
+				kengine::u32 const* triangle = &result[adjacency[i] * 3];
+				touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+			}
+
+			appliedCost = std::max(appliedCost, collapse.cost);
+			// an interior edge collapse removes its two triangles
+			remainingIndices -= std::min<kengine::usize>(remainingIndices, 6);
+			++applied;
+		}
+
+		if (applied == 0) {
+			break;
+		}
+
+		kengine::usize write = 0;
+		for (kengine::usize t = 0; t < triangleCount; ++t) {
+			kengine::u32 a = remap[result[t * 3]];
+			kengine::u32 b = remap[result[t * 3 + 1]];
+			kengine::u32 c = remap[result[t * 3 + 2]];
+			if (a == b || b == c || a == c) {
+				continue;
+			}
+
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+		result.resize(write);
+	}
+
+	if (resultError != nullptr) {
+		*resultError = static_cast<kengine::f32>(std::sqrt(appliedCost));
+	}
+
+	return result;
+}
+
+std::vector<MeshLOD> generateLODs(MeshData& mesh, kengine::u32 maxLevels, kengine::f32 reduction) {
+	std::vector<MeshLOD> lods;
+	lods.push_back({ 0, static_cast<kengine::u32>(mesh.indices.size()), 0.0f });
+
+	std::vector<kengine::u32> current = mesh.indices;
+	kengine::f32 error = 0.0f;
+
+	for (kengine::u32 level = 1; level <= maxLevels; ++level) {
+		kengine::usize target = static_cast<kengine::usize>(static_cast<kengine::f32>(current.size() / 3) * reduction) * 3;
+		if (target < 3) {
+			break;
+		}
+
+		kengine::f32 levelError = 0.0f;
+		std::vector<kengine::u32> next = simplifyMesh(mesh.vertices, current, target, std::numeric_limits<kengine::f32>::max(), &levelError);
+
+		// locked borders and seams can stall the simplifier, stop once a level stops paying for itself
+		if (next.empty() || next.size() + next.size() / 20 >= current.size()) {
+			break;
+		}
+
+		optimizeVertexCache(next, mesh.vertices.size());
+
+		// each level simplifies the previous one, so deviations from the full mesh add up
+		error += levelError;
+		lods.push_back({ static_cast<kengine::u32>(mesh.indices.size()), static_cast<kengine::u32>(next.size()), error });
+
+		mesh.indices.insert(mesh.indices.end(), next.begin(), next.end());
+		current = std::move(next);
+	}
+
+	return lods;
+}
+
+std::vector<std::vector<MeshLOD>> generateLODs(util::Span<MeshData> meshes, kengine::u32 maxLevels, kengine::f32 reduction) {
+	std::vector<std::vector<MeshLOD>> lods(meshes.size());
+
+	jobs::parallelFor(0, meshes.size(), 1, [&](kengine::usize begin, kengine::usize end) {
+		for (kengine::usize i = begin; i < end; ++i) {
+			lods[i] = generateLODs(meshes[i], maxLevels, reduction);
+		}
+	});
+
+	return lods;
+}
+
+void generateLODs(IMesh& mesh, kengine::u32 maxLevels, kengine::f32 reduction) {
+	util::Span<Vertex const> vertices = mesh.getVertices();
+	util::Span<kengine::u32 const> indices = mesh.getIndices();
+
+	MeshData data;
+	data.vertices.assign(vertices.begin(), vertices.end());
+	data.indices.assign(indices.begin(), indices.begin() + mesh.getBaseIndexCount());
+
+	std::vector<MeshLOD> lods = generateLODs(data, maxLevels, reduction);
+	mesh.setIndices(data.indices);
+	mesh.setLODs(lods);
+}
+
+} // namespace kengine::core::graphics
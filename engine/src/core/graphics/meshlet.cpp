@@ -0,0 +1,352 @@
+#include <kengine/core/graphics/meshlet.hpp>
+#include <kengine/macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef KENGINE_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace kengine::core::graphics {
+
+namespace {
+
+constexpr kengine::u32 invalidIndex = std::numeric_limits<kengine::u32>::max();
+
+void appendRange(std::vector<MeshletRange>& ranges, Meshlet const& meshlet) {
+	kengine::u32 indexCount = meshlet.triangleCount * 3;
+	if (!ranges.empty() && ranges.back().firstIndex + ranges.back().indexCount == meshlet.firstIndex) {
+		ranges.back().indexCount += indexCount;
+	} else {
+		ranges.push_back({ meshlet.firstIndex, indexCount });
+	}
+}
+
+} // namespace
+
+MeshletCullData MeshletCullData::build(util::Span<MeshletBounds const> bounds) {
+	MeshletCullData data;
+	data.count = bounds.size();
+
+	kengine::usize padded = (bounds.size() + 3) & ~static_cast<kengine::usize>(3);
+	data.centerX.assign(padded, 0.0f);
+	data.centerY.assign(padded, 0.0f);
+	data.centerZ.assign(padded, 0.0f);
+	data.radius.assign(padded, 0.0f);
+	data.axisX.assign(padded, 0.0f);
+	data.axisY.assign(padded, 0.0f);
+	data.axisZ.assign(padded, 0.0f);
+	data.cutoff.assign(padded, 1.0f);
+
+	for (kengine::usize i = 0; i < bounds.size(); ++i) {
+		data.centerX[i] = bounds[i].center[0];
+		data.centerY[i] = bounds[i].center[1];
+		data.centerZ[i] = bounds[i].center[2];
+		data.radius[i] = bounds[i].radius;
+		data.axisX[i] = bounds[i].coneAxis[0];
+		data.axisY[i] = bounds[i].coneAxis[1];
+		data.axisZ[i] = bounds[i].coneAxis[2];
+		data.cutoff[i] = bounds[i].coneCutoff;
+	}
+
+	return data;
+}
+
+Frustum Frustum::fromMatrix(kengine::f32 const* m) {
+	auto row = [m](kengine::usize i) {
+		return util::math::Vector<f32, 4>{ m[i], m[4 + i], m[8 + i], m[12 + i] };
+	};
+
+	util::math::Vector<f32, 4> x = row(0);
+	util::math::Vector<f32, 4> y = row(1);
+	util::math::Vector<f32, 4> z = row(2);
+	util::math::Vector<f32, 4> w = row(3);
+
+	Frustum frustum;
+	frustum.planes[0] = w + x;
+	frustum.planes[1] = w - x;
+	frustum.planes[2] = w + y;
+	frustum.planes[3] = w - y;
+	frustum.planes[4] = w + z;
+	frustum.planes[5] = w - z;
+
+	for (util::math::Vector<f32, 4>& plane : frustum.planes) {
+		kengine::f32 length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		if (length > 0.0f) {
+			plane /= length;
+		}
+	}
+
+	return frustum;
+}
+
+std::vector<Meshlet> buildMeshlets(util::Span<kengine::u32> indices, util::Span<Vertex const> vertices, kengine::u32 maxVertices, kengine::u32 maxTriangles) {
+	std::vector<Meshlet> meshlets;
+
+	kengine::usize triangleCount = indices.size() / 3;
+	kengine::usize vertexCount = vertices.size();
+	if (triangleCount == 0) {
+		return meshlets;
+	}
+
+	maxVertices = std::max(maxVertices, 3u);
+	maxTriangles = std::max(maxTriangles, 1u);
+
+	std::vector<kengine::u32> offsets(vertexCount + 1, 0);
+	for (kengine::usize i = 0; i < triangleCount * 3; ++i) {
+		++offsets[indices[i] + 1];
+	}
+	for (kengine::usize i = 0; i < vertexCount; ++i) {
+		offsets[i + 1] += offsets[i];
+	}
+
+	std::vector<kengine::u32> adjacency(triangleCount * 3);
+	std::vector<kengine::u32> cursor(offsets.begin(), offsets.end() - 1);
+	for (kengine::usize i = 0; i < triangleCount * 3; ++i) {
+		adjacency[cursor[indices[i]]++] = static_cast<kengine::u32>(i / 3);
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<kengine::u32> owner(vertexCount, invalidIndex);
+	std::vector<kengine::u32> meshletVertices;
+	std::vector<kengine::u32> order;
+	meshletVertices.reserve(maxVertices);
+	order.reserve(triangleCount);
+
+	Meshlet current;
+	kengine::u32 meshletId = 0;
+	kengine::usize scan = 0;
+
+	auto newVertices = [&](kengine::usize triangle) {
+		kengine::u32 const* t = &indices[triangle * 3];
+		kengine::u32 count = 0;
+		for (kengine::usize k = 0; k < 3; ++k) {
+			bool repeated = (k > 0 && t[k] == t[0]) || (k > 1 && t[k] == t[1]);
+			count += (owner[t[k]] != meshletId && !repeated) ? 1 : 0;
+		}
+		return count;
+	};
+
+	auto finish = [&]() {
+		meshlets.push_back(current);
+		current.firstIndex += current.triangleCount * 3;
+		current.triangleCount = 0;
+		current.vertexCount = 0;
+		meshletVertices.clear();
+		++meshletId;
+	};
+
+	while (order.size() < triangleCount) {
+		// prefer the neighbouring triangle that brings in the fewest new vertices
+		kengine::usize best = invalidIndex;
+		kengine::u32 bestNew = 4;
+
+		if (current.triangleCount < maxTriangles) {
+			for (kengine::u32 vertex : meshletVertices) {
+				for (kengine::u32 i = offsets[vertex]; i < offsets[vertex + 1] && bestNew > 0; ++i) {
+					kengine::u32 triangle = adjacency[i];
+					if (emitted[triangle]) {
+						continue;
+					}
+
+					kengine::u32 added = newVertices(triangle);
+					if (added < bestNew && current.vertexCount + added <= maxVertices) {
+						best = triangle;
+						bestNew = added;
+					}
+				}
+			}
+		}
+
+		if (best == invalidIndex) {
+			if (current.triangleCount > 0) {
+				finish();
+				continue;
+			}
+
+			while (emitted[scan]) {
+				++scan;
+			}
+			best = scan;
+		}
+
+		emitted[best] = true;
+		order.push_back(static_cast<kengine::u32>(best));
+
+		for (kengine::usize k = 0; k < 3; ++k) {
+			kengine::u32 vertex = indices[best * 3 + k];
+			if (owner[vertex] != meshletId) {
+				owner[vertex] = meshletId;
+				meshletVertices.push_back(vertex);
+				++current.vertexCount;
+			}
+		}
+		++current.triangleCount;
+	}
+
+	if (current.triangleCount > 0) {
+		finish();
+	}
+
+	std::vector<kengine::u32> reordered(triangleCount * 3);
+	for (kengine::usize i = 0; i < triangleCount; ++i) {
+		for (kengine::usize k = 0; k < 3; ++k) {
+			reordered[i * 3 + k] = indices[order[i] * 3 + k];
+		}
+	}
+	std::copy(reordered.begin(), reordered.end(), indices.begin());
+
+	return meshlets;
+}
+
+MeshletBounds computeMeshletBounds(util::Span<kengine::u32 const> indices, util::Span<Vertex const> vertices) {
+	MeshletBounds bounds;
+	if (indices.empty()) {
+		return bounds;
+	}
+
+	util::math::Vector<f32, 3> minimum(std::numeric_limits<kengine::f32>::max());
+	util::math::Vector<f32, 3> maximum(-std::numeric_limits<kengine::f32>::max());
+	for (kengine::u32 index : indices) {
+		for (kengine::usize k = 0; k < 3; ++k) {
+			minimum[k] = std::min(minimum[k], vertices[index].position[k]);
+			maximum[k] = std::max(maximum[k], vertices[index].position[k]);
+		}
+	}
+
+	bounds.center = (minimum + maximum) * 0.5f;
+	for (kengine::u32 index : indices) {
+		util::math::Vector<f32, 3> offset = vertices[index].position - bounds.center;
+		bounds.radius = std::max(bounds.radius, offset.dot(offset));
+	}
+	bounds.radius = std::sqrt(bounds.radius);
+
+	std::vector<util::math::Vector<f32, 3>> normals;
+	normals.reserve(indices.size() / 3);
+
+	util::math::Vector<f32, 3> axis(0.0f);
+	for (kengine::usize t = 0; t < indices.size() / 3; ++t) {
+		util::math::Vector<f32, 3> const& p0 = vertices[indices[t * 3]].position;
+		util::math::Vector<f32, 3> u = vertices[indices[t * 3 + 1]].position - p0;
+		util::math::Vector<f32, 3> v = vertices[indices[t * 3 + 2]].position - p0;
+		util::math::Vector<f32, 3> normal = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+
+		kengine::f32 length = std::sqrt(normal.dot(normal));
+		if (length <= 0.0f) {
+			continue;
+		}
+
+		normal /= length;
+		normals.push_back(normal);
+		axis += normal;
+	}
+
+	kengine::f32 axisLength = std::sqrt(axis.dot(axis));
+	if (normals.empty() || axisLength <= 0.0f) {
+		return bounds;
+	}
+
+	bounds.coneAxis = axis / axisLength;
+
+	kengine::f32 minimumDot = 1.0f;
+	for (util::math::Vector<f32, 3> const& normal : normals) {
+		minimumDot = std::min(minimumDot, normal.dot(bounds.coneAxis));
+	}
+
+	// cones wider than ~85 degrees cull too rarely to be worth testing
+	bounds.coneCutoff = minimumDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minimumDot * minimumDot);
+	return bounds;
+}
+
+std::vector<MeshletBounds> computeMeshletBounds(util::Span<Meshlet const> meshlets, util::Span<kengine::u32 const> indices, util::Span<Vertex const> vertices) {
+	std::vector<MeshletBounds> bounds;
+	bounds.reserve(meshlets.size());
+
+	for (Meshlet const& meshlet : meshlets) {
+		bounds.push_back(computeMeshletBounds(indices.subspan(meshlet.firstIndex, meshlet.triangleCount * 3), vertices));
+	}
+
+	return bounds;
+}
+
+kengine::usize cullMeshlets(MeshletCullData const& data, util::Span<Meshlet const> meshlets, Frustum const& frustum, util::math::Vector<f32, 3> const& cameraPosition, std::vector<MeshletRange>& visible) {
+	kengine::usize count = std::min(data.count, meshlets.size());
+	kengine::usize visibleCount = 0;
+
+#ifdef KENGINE_SIMD_SSE2
+	__m128 planes[6][4];
+	for (kengine::usize p = 0; p < 6; ++p) {
+		for (kengine::usize k = 0; k < 4; ++k) {
+			planes[p][k] = _mm_set1_ps(frustum.planes[p][k]);
+		}
+	}
+
+	__m128 cameraX = _mm_set1_ps(cameraPosition[0]);
+	__m128 cameraY = _mm_set1_ps(cameraPosition[1]);
+	__m128 cameraZ = _mm_set1_ps(cameraPosition[2]);
+
+	for (kengine::usize i = 0; i < count; i += 4) {
+		__m128 centerX = _mm_loadu_ps(&data.centerX[i]);
+		__m128 centerY = _mm_loadu_ps(&data.centerY[i]);
+		__m128 centerZ = _mm_loadu_ps(&data.centerZ[i]);
+		__m128 radius = _mm_loadu_ps(&data.radius[i]);
+		__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (kengine::usize p = 0; p < 6; ++p) {
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(planes[p][0], centerX), _mm_mul_ps(planes[p][1], centerY)),
+				_mm_add_ps(_mm_mul_ps(planes[p][2], centerZ), planes[p][3]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		__m128 viewX = _mm_sub_ps(centerX, cameraX);
+		__m128 viewY = _mm_sub_ps(centerY, cameraY);
+		__m128 viewZ = _mm_sub_ps(centerZ, cameraZ);
+		__m128 viewLength = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(viewX, viewX), _mm_mul_ps(viewY, viewY)), _mm_mul_ps(viewZ, viewZ)));
+		__m128 facing = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(viewX, _mm_loadu_ps(&data.axisX[i])), _mm_mul_ps(viewY, _mm_loadu_ps(&data.axisY[i]))),
+			_mm_mul_ps(viewZ, _mm_loadu_ps(&data.axisZ[i])));
+		__m128 backfacing = _mm_cmpge_ps(facing, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&data.cutoff[i]), viewLength), radius));
+
+		kengine::u32 mask = static_cast<kengine::u32>(_mm_movemask_ps(_mm_andnot_ps(backfacing, inside)));
+		for (kengine::usize k = 0; k < 4 && i + k < count; ++k) {
+			if (mask & (1u << k)) {
+				appendRange(visible, meshlets[i + k]);
+				++visibleCount;
+			}
+		}
+	}
+#else
+	for (kengine::usize i = 0; i < count; ++i) {
+		util::math::Vector<f32, 3> center = { data.centerX[i], data.centerY[i], data.centerZ[i] };
+
+		bool inside = true;
+		for (util::math::Vector<f32, 4> const& plane : frustum.planes) {
+			if (plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -data.radius[i]) {
+				inside = false;
+				break;
+			}
+		}
+
+		if (!inside) {
+			continue;
+		}
+
+		util::math::Vector<f32, 3> view = center - cameraPosition;
+		util::math::Vector<f32, 3> axis = { data.axisX[i], data.axisY[i], data.axisZ[i] };
+		if (view.dot(axis) >= data.cutoff[i] * std::sqrt(view.dot(view)) + data.radius[i]) {
+			continue;
+		}
+
+		appendRange(visible, meshlets[i]);
+		++visibleCount;
+	}
+#endif
+
+	return visibleCount;
+}
+
+} // namespace kengine::core::graphics
@@ -0,0 +1,95 @@
+#include "renderer_null.hpp"
+
+#include <chrono>
+#include <algorithm>
+
+namespace kengine::core::graphics::null {
+
+RendererNull::~RendererNull() {
+	for (IObject* object : _objects) {
+		delete object;
+	}
+
+	for (MeshNull* mesh : _meshes) {
+		delete mesh;
+	}
+}
+
+void RendererNull::render() {
+	using clock = std::chrono::steady_clock;
+
+	kengine::u64 frameCount = _statistics.frameCount + 1;
+	_statistics = RenderStatistics();
+	_statistics.frameCount = frameCount;
+	_statistics.commandCount = _commands.size();
+
+	clock::time_point start = clock::now();
+	_commands.sort();
+	clock::time_point sorted = clock::now();
+
+	for (CommandEntry const& entry : _commands) {
+		_execute(*entry.packet);
+	}
+	_commands.clear();
+	clock::time_point replayed = clock::now();
+
+	_statistics.sortMilliseconds = std::chrono::duration<kengine::f64, std::milli>(sorted - start).count();
+	_statistics.replayMilliseconds = std::chrono::duration<kengine::f64, std::milli>(replayed - sorted).count();
+}
+
+void RendererNull::submit(CommandBuffer const& commands) {
+	_commands.submit(commands);
+}
+
+IMesh* RendererNull::createMesh(VertexLayout const&) {
+	MeshNull* mesh = new MeshNull();
+	_meshes.push_back(mesh);
+	return mesh;
+}
+
+void RendererNull::destroyMesh(IMesh* mesh) {
+	auto it = std::find(_meshes.begin(), _meshes.end(), mesh);
+	if (it == _meshes.end()) {
+		throw RendererException("RendererNull::destroyMesh: Mesh was not created by this renderer");
+	}
+
+	delete *it;
+	_meshes.erase(it);
+}
+
+IObject* RendererNull::createObject(IMesh* mesh) {
+	IObject* object = new IObject(mesh);
+	_objects.push_back(object);
+	return object;
+}
+
+void RendererNull::_execute(CommandPacket const& packet) {
+	switch (packet.type) {
+	case CommandType::Clear:
+		++_statistics.clearCount;
+		break;
+	case CommandType::Viewport:
+		++_statistics.viewportCount;
+		break;
+	case CommandType::State: {
+		kengine::u32 state = packet.as<StateCommand>().state;
+		if (state != _state) {
+			++_statistics.stateChangeCount;
+			_state = state;
+		}
+		break;
+	}
+	case CommandType::Draw: {
+		DrawCommand const& command = packet.as<DrawCommand>();
+		if (command.mesh == nullptr) {
+			break;
+		}
+
+		++_statistics.drawCount;
+		_statistics.triangleCount += _selectDrawRange(command).indexCount / 3;
+		break;
+	}
+	}
+}
+
+} // namespace kengine::core::graphics::null
@@ -0,0 +1,53 @@
+#ifndef KENGINE_CORE_GRAPHICS_NULL_RENDERER_HPP
+#define KENGINE_CORE_GRAPHICS_NULL_RENDERER_HPP
+
+#include <vector>
+
+#include <kengine/core/graphics/renderer.hpp>
+#include <kengine/core/graphics/command.hpp>
+
+namespace kengine::core::graphics::null {
+
+class MeshNull : public IMesh {
+public:
+	MeshNull() = default;
+	~MeshNull() override = default;
+
+	util::Span<Vertex const> getVertices() const override { return _vertices; }
+	void setVertices(util::Span<Vertex const> vertices) override { _vertices.assign(vertices.begin(), vertices.end()); }
+
+	util::Span<kengine::u32 const> getIndices() const override { return _indices; }
+	void setIndices(util::Span<kengine::u32 const> indices) override { _indices.assign(indices.begin(), indices.end()); }
+
+private:
+	std::vector<Vertex> _vertices;
+	std::vector<kengine::u32> _indices;
+};
+
+// consumes the command stream without touching a GPU, recording statistics for headless benchmarking
+class RendererNull : public IRenderer {
+public:
+	RendererNull() = default;
+	~RendererNull() override;
+
+	void render() override;
+	void submit(CommandBuffer const& commands) override;
+
+	using IRenderer::createMesh;
+	IMesh* createMesh(VertexLayout const& layout) override;
+	void destroyMesh(IMesh* mesh) override;
+	IObject* createObject(IMesh* mesh) override;
+
+private:
+	void _execute(CommandPacket const& packet);
+
+	CommandQueue _commands;
+	kengine::u32 _state = StateDepthWrite;
+
+	std::vector<MeshNull*> _meshes;
+	std::vector<IObject*> _objects;
+};
+
+} // namespace kengine::core::graphics::null
+
+#endif
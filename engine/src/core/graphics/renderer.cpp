@@ -1,14 +1,35 @@
 #include <kengine/core/graphics/renderer.hpp>
 #include "gl41/renderer_gl41.hpp"
+#include "null/renderer_null.hpp"
 
 namespace kengine::core::graphics {
 
-IRenderer& Renderer::create(window::IWindow& window) {
-	return *new gl41::RendererGL41(window);
+IRenderer& Renderer::create(window::IWindow& window, RendererBackend backend) {
+	switch (backend) {
+	case RendererBackend::GL41:
+		return *new gl41::RendererGL41(window);
+	case RendererBackend::Null:
+		return *new null::RendererNull();
+	}
+
+	throw RendererException("Renderer::create: Unknown renderer backend");
+}
+
+IRenderer& Renderer::create(RendererBackend backend) {
+	if (backend != RendererBackend::Null) {
+		throw RendererException("Renderer::create: Only the null renderer backend can be created without a window");
+	}
+
+	return *new null::RendererNull();
 }
 
 void Renderer::destroy(IRenderer& renderer) {
-	delete dynamic_cast<gl41::RendererGL41*>(&renderer);
+	if (gl41::RendererGL41* gl41Renderer = dynamic_cast<gl41::RendererGL41*>(&renderer)) {
+		delete gl41Renderer;
+		return;
+	}
+
+	delete dynamic_cast<null::RendererNull*>(&renderer);
 }
 
 } // namespace kengine::core
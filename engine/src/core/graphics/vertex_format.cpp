@@ -0,0 +1,376 @@
+#include <kengine/core/graphics/vertex_format.hpp>
+#include <kengine/macros.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#ifdef KENGINE_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef KENGINE_SIMD_F16C
+#include <immintrin.h>
+#endif
+
+namespace kengine::core::graphics {
+
+namespace {
+
+kengine::u32 positionFormatSize(PositionFormat format) {
+	return format == PositionFormat::Float32 ? 12 : 8;
+}
+
+kengine::u32 normalFormatSize(NormalFormat format) {
+	return format == NormalFormat::Float32 ? 12 : 4;
+}
+
+kengine::u32 texCoordFormatSize(TexCoordFormat format) {
+	return format == TexCoordFormat::Float32 ? 8 : 4;
+}
+
+kengine::s16 quantizeSnorm16(kengine::f32 value) {
+	value = std::min(std::max(value, -1.0f), 1.0f);
+	return static_cast<kengine::s16>(std::lround(value * 32767.0f));
+}
+
+kengine::u16 quantizeUnorm16(kengine::f32 value) {
+	value = std::min(std::max(value, 0.0f), 1.0f);
+	return static_cast<kengine::u16>(std::lround(value * 65535.0f));
+}
+
+void encodeOctahedral(util::math::Vector<f32, 3> const& normal, kengine::s16* out) {
+	kengine::f32 x = normal[0];
+	kengine::f32 y = normal[1];
+	kengine::f32 z = normal[2];
+
+	kengine::f32 length = std::fabs(x) + std::fabs(y) + std::fabs(z);
+	if (length > 0.0f) {
+		x /= length;
+		y /= length;
+		z /= length;
+	}
+
+	if (z < 0.0f) {
+		kengine::f32 foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		kengine::f32 foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	out[0] = quantizeSnorm16(x);
+	out[1] = quantizeSnorm16(y);
+}
+
+util::math::Vector<f32, 3> decodeOctahedral(kengine::s16 const* in) {
+	kengine::f32 x = std::max(in[0] / 32767.0f, -1.0f);
+	kengine::f32 y = std::max(in[1] / 32767.0f, -1.0f);
+	kengine::f32 z = 1.0f - std::fabs(x) - std::fabs(y);
+
+	kengine::f32 t = std::max(-z, 0.0f);
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+
+	kengine::f32 length = std::sqrt(x * x + y * y + z * z);
+	return { x / length, y / length, z / length };
+}
+
+void encodePosition(util::math::Vector<f32, 3> const& position, PositionFormat format, kengine::f32 const* center, kengine::f32 const* inverseExtent, kengine::u8* out) {
+	switch (format) {
+	case PositionFormat::Float32:
+		std::memcpy(out, position.data(), sizeof(f32) * 3);
+		break;
+	case PositionFormat::Half: {
+#ifdef KENGINE_SIMD_F16C
+		__m128 p = _mm_setr_ps(position[0], position[1], position[2], 0.0f);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_cvtps_ph(p, _MM_FROUND_TO_NEAREST_INT));
+#else
+		kengine::u16 half[4] = { floatToHalf(position[0]), floatToHalf(position[1]), floatToHalf(position[2]), 0 };
+		std::memcpy(out, half, sizeof(half));
+#endif
+		break;
+	}
+	case PositionFormat::Snorm16: {
+#ifdef KENGINE_SIMD_SSE2
+		__m128 p = _mm_setr_ps(position[0], position[1], position[2], 0.0f);
+		p = _mm_mul_ps(_mm_sub_ps(p, _mm_loadu_ps(center)), _mm_loadu_ps(inverseExtent));
+		p = _mm_min_ps(_mm_max_ps(p, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+		__m128i q = _mm_cvtps_epi32(_mm_mul_ps(p, _mm_set1_ps(32767.0f)));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(q, q));
+#else
+		kengine::s16 q[4] = {
+			quantizeSnorm16((position[0] - center[0]) * inverseExtent[0]),
+			quantizeSnorm16((position[1] - center[1]) * inverseExtent[1]),
+			quantizeSnorm16((position[2] - center[2]) * inverseExtent[2]),
+			0,
+		};
+		std::memcpy(out, q, sizeof(q));
+#endif
+		break;
+	}
+	}
+}
+
+util::math::Vector<f32, 3> decodePosition(kengine::u8 const* in, PositionFormat format, MeshBounds const& bounds) {
+	util::math::Vector<f32, 3> position;
+	switch (format) {
+	case PositionFormat::Float32:
+		std::memcpy(position.data(), in, sizeof(f32) * 3);
+		break;
+	case PositionFormat::Half: {
+		kengine::u16 half[4];
+		std::memcpy(half, in, sizeof(half));
+		position = { halfToFloat(half[0]), halfToFloat(half[1]), halfToFloat(half[2]) };
+		break;
+	}
+	case PositionFormat::Snorm16: {
+#ifdef KENGINE_SIMD_SSE2
+		__m128i q = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(in));
+		__m128 p = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(q, q), 16));
+		p = _mm_max_ps(_mm_mul_ps(p, _mm_set1_ps(1.0f / 32767.0f)), _mm_set1_ps(-1.0f));
+
+		kengine::f32 result[4];
+		_mm_storeu_ps(result, p);
+		for (kengine::usize i = 0; i < 3; ++i) {
+			position[i] = result[i] * bounds.extent[i] + bounds.center[i];
+		}
+#else
+		kengine::s16 q[4];
+		std::memcpy(q, in, sizeof(q));
+		for (kengine::usize i = 0; i < 3; ++i) {
+			position[i] = std::max(q[i] / 32767.0f, -1.0f) * bounds.extent[i] + bounds.center[i];
+		}
+#endif
+		break;
+	}
+	}
+
+	return position;
+}
+
+void encodeTexCoords(util::math::Vector<f32, 2> const& texCoords, TexCoordFormat format, kengine::u8* out) {
+	switch (format) {
+	case TexCoordFormat::Float32:
+		std::memcpy(out, texCoords.data(), sizeof(f32) * 2);
+		break;
+	case TexCoordFormat::Half: {
+		kengine::u16 half[2] = { floatToHalf(texCoords[0]), floatToHalf(texCoords[1]) };
+		std::memcpy(out, half, sizeof(half));
+		break;
+	}
+	case TexCoordFormat::Unorm16: {
+		kengine::u16 q[2] = { quantizeUnorm16(texCoords[0]), quantizeUnorm16(texCoords[1]) };
+		std::memcpy(out, q, sizeof(q));
+		break;
+	}
+	}
+}
+
+util::math::Vector<f32, 2> decodeTexCoords(kengine::u8 const* in, TexCoordFormat format) {
+	util::math::Vector<f32, 2> texCoords;
+	switch (format) {
+	case TexCoordFormat::Float32:
+		std::memcpy(texCoords.data(), in, sizeof(f32) * 2);
+		break;
+	case TexCoordFormat::Half: {
+		kengine::u16 half[2];
+		std::memcpy(half, in, sizeof(half));
+		texCoords = { halfToFloat(half[0]), halfToFloat(half[1]) };
+		break;
+	}
+	case TexCoordFormat::Unorm16: {
+		kengine::u16 q[2];
+		std::memcpy(q, in, sizeof(q));
+		texCoords = { q[0] / 65535.0f, q[1] / 65535.0f };
+		break;
+	}
+	}
+
+	return texCoords;
+}
+
+} // namespace
+
+VertexLayout VertexLayout::make(PositionFormat position, NormalFormat normal, TexCoordFormat texCoords) {
+	VertexLayout layout;
+	layout.position = position;
+	layout.normal = normal;
+	layout.texCoords = texCoords;
+
+	layout.positionOffset = 0;
+	layout.normalOffset = layout.positionOffset + positionFormatSize(position);
+	layout.texCoordsOffset = layout.normalOffset + normalFormatSize(normal);
+	layout.stride = layout.texCoordsOffset + texCoordFormatSize(texCoords);
+	return layout;
+}
+
+MeshBounds computeBounds(util::Span<Vertex const> vertices) {
+	MeshBounds bounds;
+	if (vertices.empty()) {
+		bounds.extent = { 1.0f, 1.0f, 1.0f };
+		return bounds;
+	}
+
+	util::math::Vector<f32, 3> min = vertices[0].position;
+	util::math::Vector<f32, 3> max = vertices[0].position;
+	for (Vertex const& vertex : vertices) {
+		for (kengine::usize i = 0; i < 3; ++i) {
+			min[i] = std::min(min[i], vertex.position[i]);
+			max[i] = std::max(max[i], vertex.position[i]);
+		}
+	}
+
+	bounds.center = (min + max) * 0.5f;
+	bounds.extent = (max - min) * 0.5f;
+	for (kengine::usize i = 0; i < 3; ++i) {
+		// flat axes still need a usable scale for quantization
+		if (bounds.extent[i] <= 0.0f) {
+			bounds.extent[i] = 1.0f;
+		}
+	}
+
+	return bounds;
+}
+
+kengine::usize indexFormatSize(IndexFormat format) {
+	return format == IndexFormat::U16 ? sizeof(kengine::u16) : sizeof(kengine::u32);
+}
+
+IndexFormat chooseIndexFormat(util::Span<kengine::u32 const> indices) {
+	for (kengine::u32 index : indices) {
+		if (index > 0xFFFF) {
+			return IndexFormat::U32;
+		}
+	}
+
+	return IndexFormat::U16;
+}
+
+void encodeVertices(util::Span<Vertex const> vertices, VertexLayout const& layout, MeshBounds const& bounds, kengine::u8* out) {
+	kengine::f32 center[4] = { bounds.center[0], bounds.center[1], bounds.center[2], 0.0f };
+	kengine::f32 inverseExtent[4] = { 1.0f / bounds.extent[0], 1.0f / bounds.extent[1], 1.0f / bounds.extent[2], 0.0f };
+
+	for (Vertex const& vertex : vertices) {
+		encodePosition(vertex.position, layout.position, center, inverseExtent, out + layout.positionOffset);
+
+		if (layout.normal == NormalFormat::Float32) {
+			std::memcpy(out + layout.normalOffset, vertex.normal.data(), sizeof(f32) * 3);
+		} else {
+			kengine::s16 octahedral[2];
+			encodeOctahedral(vertex.normal, octahedral);
+			std::memcpy(out + layout.normalOffset, octahedral, sizeof(octahedral));
+		}
+
+		encodeTexCoords(vertex.texCoords, layout.texCoords, out + layout.texCoordsOffset);
+		out += layout.stride;
+	}
+}
+
+void decodeVertices(kengine::u8 const* data, kengine::usize count, VertexLayout const& layout, MeshBounds const& bounds, Vertex* out) {
+	for (kengine::usize i = 0; i < count; ++i) {
+		Vertex& vertex = out[i];
+		vertex.position = decodePosition(data + layout.positionOffset, layout.position, bounds);
+
+		if (layout.normal == NormalFormat::Float32) {
+			std::memcpy(vertex.normal.data(), data + layout.normalOffset, sizeof(f32) * 3);
+		} else {
+			kengine::s16 octahedral[2];
+			std::memcpy(octahedral, data + layout.normalOffset, sizeof(octahedral));
+			vertex.normal = decodeOctahedral(octahedral);
+		}
+
+		vertex.texCoords = decodeTexCoords(data + layout.texCoordsOffset, layout.texCoords);
+		data += layout.stride;
+	}
+}
+
+void encodeIndices(util::Span<kengine::u32 const> indices, IndexFormat format, void* out) {
+	if (format == IndexFormat::U32) {
+		std::memcpy(out, indices.data(), indices.size() * sizeof(kengine::u32));
+		return;
+	}
+
+	kengine::u16* out16 = static_cast<kengine::u16*>(out);
+	kengine::usize i = 0;
+
+#ifdef KENGINE_SIMD_SSE2
+	// narrow 8 indices at a time, biased so the signed saturating pack keeps the full u16 range
+	__m128i bias32 = _mm_set1_epi32(0x8000);
+	__m128i bias16 = _mm_set1_epi16(static_cast<kengine::s16>(0x8000));
+	for (; i + 8 <= indices.size(); i += 8) {
+		__m128i a = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(indices.data() + i)), bias32);
+		__m128i b = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(indices.data() + i + 4)), bias32);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out16 + i), _mm_xor_si128(_mm_packs_epi32(a, b), bias16));
+	}
+#endif
+
+	for (; i < indices.size(); ++i) {
+		out16[i] = static_cast<kengine::u16>(indices[i]);
+	}
+}
+
+kengine::u16 floatToHalf(kengine::f32 value) {
+	kengine::u32 bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	kengine::u32 sign = (bits >> 16) & 0x8000;
+	kengine::u32 magnitude = bits & 0x7FFFFFFF;
+
+	// infinity and nan
+	if (magnitude >= 0x7F800000) {
+		return static_cast<kengine::u16>(sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0));
+	}
+
+	// rounds to infinity
+	if (magnitude >= 0x477FF000) {
+		return static_cast<kengine::u16>(sign | 0x7C00);
+	}
+
+	// subnormal halves
+	if (magnitude < 0x38800000) {
+		if (magnitude < 0x33000000) {
+			return static_cast<kengine::u16>(sign);
+		}
+
+		kengine::u32 mantissa = (magnitude & 0x007FFFFF) | 0x00800000;
+		kengine::u32 shift = 126 - (magnitude >> 23);
+		kengine::u32 half = mantissa >> shift;
+		kengine::u32 remainder = mantissa & ((1u << shift) - 1);
+		kengine::u32 halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half & 1))) {
+			++half;
+		}
+
+		return static_cast<kengine::u16>(sign | half);
+	}
+
+	kengine::u32 half = (magnitude - 0x38000000) >> 13;
+	kengine::u32 remainder = magnitude & 0x1FFF;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+		++half;
+	}
+
+	return static_cast<kengine::u16>(sign | half);
+}
+
+kengine::f32 halfToFloat(kengine::u16 value) {
+	kengine::u32 sign = static_cast<kengine::u32>(value & 0x8000) << 16;
+	kengine::u32 exponent = (value >> 10) & 0x1F;
+	kengine::u32 mantissa = value & 0x3FF;
+
+	kengine::u32 bits;
+	if (exponent == 0) {
+		kengine::f32 subnormal = static_cast<kengine::f32>(mantissa) * (1.0f / 16777216.0f);
+		return sign ? -subnormal : subnormal;
+	} else if (exponent == 0x1F) {
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	} else {
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+
+	kengine::f32 result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+} // namespace kengine::core::graphics
@@ -0,0 +1,334 @@
+#include <kengine/core/jobs/job_system.hpp>
+#include <kengine/core/exception.hpp>
+#include <kengine/core/logging.hpp>
+#include <kengine/macros.hpp>
+
+#include <algorithm>
+
+#ifdef KENGINE_PLATFORM_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#elif defined(KENGINE_PLATFORM_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace kengine::core::jobs {
+
+namespace {
+
+thread_local kengine::u32 currentWorker = JobSystem::invalidWorker;
+thread_local kengine::u32 foreignStealSeed = 0x9E3779B9u;
+
+kengine::u32 nextRandom(kengine::u32& state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+template<typename Handle>
+void pinThread(Handle handle, kengine::u32 core) {
+#ifdef KENGINE_PLATFORM_WINDOWS
+	SetThreadAffinityMask(handle, static_cast<DWORD_PTR>(1) << core);
+#elif defined(KENGINE_PLATFORM_LINUX)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	pthread_setaffinity_np(handle, sizeof(set), &set);
+#else
+	(void)handle;
+	(void)core;
+#endif
+}
+
+} // namespace
+
+JobSystem::~JobSystem() {
+	shutdown();
+}
+
+void JobSystem::init(JobSystemConfig const& config) {
+	if (_running.load(std::memory_order_acquire)) {
+		throw kengine::core::Exception("JobSystem already initialized");
+	}
+
+	kengine::u32 hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	kengine::u32 threadCount = config.workerCount != 0 ? config.workerCount : hardwareThreads - 1;
+
+	_workers.clear();
+	for (kengine::u32 i = 0; i <= threadCount; ++i) {
+		_workers.push_back(std::make_unique<Worker>());
+		_workers.back()->stealSeed = (i + 1) * 2654435761u;
+	}
+
+	_queued.store(0, std::memory_order_relaxed);
+	_running.store(true, std::memory_order_release);
+	currentWorker = 0;
+
+	if (config.pinWorkers) {
+#ifdef KENGINE_PLATFORM_WINDOWS
+		pinThread(GetCurrentThread(), 0);
+#elif defined(KENGINE_PLATFORM_LINUX)
+		pinThread(pthread_self(), 0);
+#endif
+	}
+
+	for (kengine::u32 i = 1; i <= threadCount; ++i) {
+		_workers[i]->thread = std::thread(&JobSystem::_workerMain, this, i);
+
+		if (config.pinWorkers) {
+			pinThread(_workers[i]->thread.native_handle(), i % hardwareThreads);
+		}
+	}
+
+	KENGINE_LOG(Jobs, Verbose, "JobSystem: started {} workers", threadCount + 1);
+}
+
+void JobSystem::shutdown() {
+	if (!_running.exchange(false, std::memory_order_acq_rel)) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+	}
+	_wake.notify_all();
+
+	for (kengine::usize i = 1; i < _workers.size(); ++i) {
+		if (_workers[i]->thread.joinable()) {
+			_workers[i]->thread.join();
+		}
+	}
+
+	// whatever the workers left queued runs here, anything it submits runs inline now that _running is off
+	for (;;) {
+		Job* job = nullptr;
+		for (std::unique_ptr<Worker>& worker : _workers) {
+			if ((job = worker->deque.steal()) != nullptr) {
+				break;
+			}
+		}
+
+		if (job == nullptr && !_injected.empty()) {
+			job = _injected.front();
+			_injected.pop_front();
+		}
+
+		if (job == nullptr) {
+			break;
+		}
+
+		_queued.fetch_sub(1);
+		_execute(job);
+	}
+
+	_workers.clear();
+	currentWorker = invalidWorker;
+}
+
+Job* JobSystem::create(JobFunction function, void* data, Counter* counter) {
+	Job* job = _allocate();
+	job->function = function;
+	job->data = data;
+	job->counter = counter;
+	job->pending.store(1, std::memory_order_relaxed);
+	job->continuationCount.store(0, std::memory_order_relaxed);
+
+	if (counter != nullptr) {
+		counter->_value.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+void JobSystem::addDependency(Job* before, Job* after) {
+	kengine::u32 slot = before->continuationCount.fetch_add(1, std::memory_order_relaxed);
+	if (slot >= maxContinuations) {
+		throw kengine::core::Exception("JobSystem::addDependency: a job can release at most {} continuations", maxContinuations);
+	}
+
+	after->pending.fetch_add(1, std::memory_order_relaxed);
+	before->continuations[slot] = after;
+}
+
+void JobSystem::submit(Job* job) {
+	if (job->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		_push(job);
+	}
+}
+
+Job* JobSystem::run(JobFunction function, void* data, Counter* counter) {
+	Job* job = create(function, data, counter);
+	submit(job);
+	return job;
+}
+
+void JobSystem::wait(Counter const& counter) {
+	kengine::u32 index = currentWorker;
+
+	while (!counter.isDone()) {
+		if (Job* job = _next(index)) {
+			_execute(job);
+		} else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+kengine::u32 JobSystem::getWorkerIndex() const {
+	return currentWorker;
+}
+
+void JobSystem::_workerMain(kengine::u32 index) {
+	currentWorker = index;
+
+	kengine::u32 idleSpins = 0;
+	while (_running.load(std::memory_order_acquire)) {
+		if (Job* job = _next(index)) {
+			_execute(job);
+			idleSpins = 0;
+			continue;
+		}
+
+		if (++idleSpins < 64) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_sleepMutex);
+		_sleeping.fetch_add(1);
+		_wake.wait(lock, [this]() {
+			return _queued.load() > 0 || !_running.load();
+		});
+		_sleeping.fetch_sub(1);
+		idleSpins = 0;
+	}
+
+	currentWorker = invalidWorker;
+}
+
+Job* JobSystem::_next(kengine::u32 index) {
+	if (_workers.empty()) {
+		return nullptr;
+	}
+
+	Job* job = index != invalidWorker ? _workers[index]->deque.pop() : nullptr;
+
+	if (job == nullptr) {
+		kengine::u32& seed = index != invalidWorker ? _workers[index]->stealSeed : foreignStealSeed;
+		kengine::usize count = _workers.size();
+		kengine::usize start = nextRandom(seed) % count;
+
+		for (kengine::usize i = 0; i < count && job == nullptr; ++i) {
+			kengine::usize victim = (start + i) % count;
+			if (victim != index) {
+				job = _workers[victim]->deque.steal();
+			}
+		}
+	}
+
+	if (job == nullptr) {
+		std::unique_lock<std::mutex> lock(_injectionMutex, std::try_to_lock);
+		if (lock.owns_lock() && !_injected.empty()) {
+			job = _injected.front();
+			_injected.pop_front();
+		}
+	}
+
+	if (job != nullptr) {
+		_queued.fetch_sub(1);
+	}
+
+	return job;
+}
+
+void JobSystem::_execute(Job* job) {
+	// nothing can be added to a job once it runs, so its slot is released up front;
+	// a ring wrapping onto a job further up this stack would otherwise wait on itself
+	JobFunction function = job->function;
+	void* data = job->data;
+	Counter* counter = job->counter;
+
+	Job* continuations[maxContinuations];
+	kengine::u32 continuationCount = std::min<kengine::u32>(job->continuationCount.load(std::memory_order_acquire), maxContinuations);
+	std::copy(job->continuations, job->continuations + continuationCount, continuations);
+
+	job->live.store(false, std::memory_order_release);
+
+	function(data);
+
+	for (kengine::u32 i = 0; i < continuationCount; ++i) {
+		submit(continuations[i]);
+	}
+
+	// last, so a waiter never sees the counter drop before the continuations are released
+	if (counter != nullptr) {
+		counter->_value.fetch_sub(1, std::memory_order_acq_rel);
+	}
+}
+
+Job* JobSystem::_allocate() {
+	kengine::u32 index = currentWorker;
+	if (index != invalidWorker && index < _workers.size()) {
+		JobRing& ring = _workers[index]->ring;
+		Job* job = &ring.jobs[ring.next++ & (jobsPerRing - 1)];
+
+		// the ring wrapped onto a job that is still queued or running, help until it finished
+		while (job->live.load(std::memory_order_acquire)) {
+			if (Job* other = _next(index)) {
+				_execute(other);
+			} else {
+				std::this_thread::yield();
+			}
+		}
+
+		job->live.store(true, std::memory_order_relaxed);
+		return job;
+	}
+
+	// foreign threads share one ring, they wait without running jobs so the lock is never held across one
+	for (;;) {
+		{
+			std::lock_guard<std::mutex> lock(_foreignMutex);
+			Job* job = &_foreignRing.jobs[_foreignRing.next & (jobsPerRing - 1)];
+			if (!job->live.load(std::memory_order_acquire)) {
+				++_foreignRing.next;
+				job->live.store(true, std::memory_order_relaxed);
+				return job;
+			}
+		}
+
+		std::this_thread::yield();
+	}
+}
+
+void JobSystem::_push(Job* job) {
+	// without workers everything runs inline, which keeps callers correct before init and after shutdown
+	if (!_running.load(std::memory_order_acquire)) {
+		_execute(job);
+		return;
+	}
+
+	kengine::u32 index = currentWorker;
+	if (index != invalidWorker) {
+		if (!_workers[index]->deque.push(job)) {
+			_execute(job);
+			return;
+		}
+	} else {
+		std::lock_guard<std::mutex> lock(_injectionMutex);
+		_injected.push_back(job);
+	}
+
+	_queued.fetch_add(1);
+
+	if (_sleeping.load() > 0) {
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_wake.notify_one();
+	}
+}
+
+} // namespace kengine::core::jobs
@@ -1,21 +1,29 @@
 #include <kengine/core/kengine.hpp>
 #include <kengine/core/logging.hpp>
+#include <kengine/core/event.hpp>
 #include <kengine/core/window/window.hpp>
 #include <kengine/core/graphics/renderer.hpp>
 #include <kengine/core/platform/platform.hpp>
 #include <kengine/core/platform/memory.hpp>
+#include <kengine/core/jobs/job_system.hpp>
+#include <kengine/core/timing.hpp>
+#include <kengine/core/profiler.hpp>
 #include <kengine/core/assets/asset.hpp>
 #include <kengine/core/assets/text.hpp>
 #include <kengine/core/assets/image.hpp>
 #include <kengine/core/assets/manager.hpp>
 
+#include <algorithm>
+
 namespace kengine::core {
 
 void KEngine::run() {
+	Logger::get().start();
 	Logger::get().logf(LogSeverity::Verbose, "hello world {}", "\"this is the zaza man speaking\"");
 	platform::IPlatform& platform = platform::Platform::get().create();
 
 	platform.init();
+	jobs::JobSystem::get().init();
 
 	{
 		window::IWindow& window = window::Window::get().create("KEngine Window", 800, 600);
@@ -32,20 +40,69 @@ void KEngine::run() {
 			assets::AssetReference<assets::ImageAsset> imageAssetReference = assets::Manager::get().load<assets::ImageAsset>("test.png");
 			assets::ImageAsset& imageAsset = assets::Manager::get().getReference<assets::ImageAsset>(imageAssetReference);
 			Logger::get().logf(LogSeverity::Info, "ImageAsset UUID: {}", imageAsset.getUUID());
-		} catch (Exception) {
+		} catch (Exception const& exception) {
+			exception.log();
 			Logger::get().logf(LogSeverity::Error, "Failed to load image asset");
 		}
 
 		Logger::get().logf(LogSeverity::Info, "TextAsset static UUID: {}", assets::TextAsset::getUUIDStatic());
 		Logger::get().logf(LogSeverity::Info, "ImageAsset static UUID: {}", assets::ImageAsset::getUUIDStatic());
 
+		// printAllocations writes to the sink directly, let the queued lines go first
+		Logger::get().flush();
 		platform::Memory::get().printAllocations(Logger::get().getLogger(), LogSeverity::Info);
 
-		while (!window.isClosed()) {
-			platform.update();
-			renderer.render();
+		kengine::u32 latency = std::max(_config.maxFrameLatency, 1u);
+		_frames.clear();
+		for (kengine::u32 i = 0; i < latency; ++i) {
+			_frames.push_back(std::make_unique<FrameContext>());
+		}
+
+		_timestep = FixedTimestep(_config.fixedTimestep);
+		_simulationTime = platform.getTime();
+
+		FramePacer pacer(_config.targetFrameTime);
+
+		_simulatedFrames.store(0);
+		_renderedFrames.store(0);
+		_running.store(true);
+
+		for (kengine::u64 frame = 0; !window.isClosed(); ++frame) {
+			KENGINE_PROFILE_FRAME();
+
+			{
+				KENGINE_PROFILE_ZONE("Platform update");
+				platform.update();
+			}
+
+			// the frame to render has to be simulated, keep the job going until it is
+			{
+				KENGINE_PROFILE_ZONE("Wait for simulation");
+				while (_simulatedFrames.load(std::memory_order_acquire) <= frame) {
+					_kickSimulation();
+					jobs::JobSystem::get().wait(_simulation);
+				}
+			}
+
+			{
+				KENGINE_PROFILE_ZONE("Render");
+				FrameContext& current = *_frames[frame % latency];
+				renderer.submit(current.commands);
+				renderer.render();
+			}
+
+			// the slot is free again, let the simulation move into it while the next frame polls and renders
+			_renderedFrames.store(frame + 1, std::memory_order_release);
+			_kickSimulation();
+
+			KENGINE_PROFILE_ZONE("Frame pacing");
+			pacer.wait(platform);
 		}
 
+		_running.store(false);
+		jobs::JobSystem::get().wait(_simulation);
+		_frames.clear();
+
 		assets::Manager::get().unloadAll();
 
 		platform::Memory::get().deallocAligned(mem, 63);
@@ -54,7 +111,66 @@ void KEngine::run() {
 		window::Window::get().destroy(window);
 	}
 
+	jobs::JobSystem::get().shutdown();
 	platform.shutdown();
+	Logger::get().stop();
+}
+
+void KEngine::_simulate(void* data) {
+	KEngine& engine = *static_cast<KEngine*>(data);
+	kengine::u64 latency = engine._frames.size();
+
+	// frame f reuses the slot of frame f - latency, which must have been rendered
+	for (kengine::u64 frame = engine._simulatedFrames.load(std::memory_order_relaxed); engine._running.load(std::memory_order_acquire); ++frame) {
+		if (frame >= engine._renderedFrames.load(std::memory_order_acquire) + latency) {
+			break;
+		}
+
+		KENGINE_PROFILE_ZONE("Simulate");
+
+		FrameContext& context = *engine._frames[frame % latency];
+		context.index = frame;
+		context.time = platform::Platform::get().getPlatform().getTime();
+		context.deltaTime = context.time - engine._simulationTime;
+		engine._simulationTime = context.time;
+
+		// events queued from any thread since the last frame reach their listeners here, before the game sees the frame
+		{
+			KENGINE_PROFILE_ZONE("Dispatch events");
+			EventSystem::get().dispatchQueuedEvents();
+		}
+
+		kengine::u32 steps = engine._timestep.advance(context.deltaTime);
+		if (engine._config.fixedUpdate != nullptr) {
+			for (kengine::u32 i = 0; i < steps; ++i) {
+				engine._config.fixedUpdate(engine._timestep.getStep(), engine._config.userData);
+			}
+		}
+		context.alpha = engine._timestep.getAlpha();
+
+		context.commands.reset();
+
+		if (engine._config.update != nullptr) {
+			engine._config.update(context, engine._config.userData);
+		} else {
+			context.commands.clear(graphics::makeSortKey(graphics::RenderPass::Clear, 0, 0), { 0.0f, 1.0f, 0.0f, 1.0f });
+		}
+
+		engine._simulatedFrames.store(frame + 1, std::memory_order_release);
+	}
+}
+
+void KEngine::_kickSimulation() {
+	// only this thread starts the job, so an idle counter means nothing is simulating
+	if (!_simulation.isDone()) {
+		return;
+	}
+
+	if (_simulatedFrames.load(std::memory_order_acquire) >= _renderedFrames.load(std::memory_order_acquire) + _frames.size()) {
+		return;
+	}
+
+	jobs::JobSystem::get().run(&KEngine::_simulate, this, &_simulation);
 }
 
 } // namespace kengine::core
@@ -0,0 +1,338 @@
+#include <kengine/core/logging.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+
+namespace kengine::core {
+
+namespace {
+
+thread_local LogQueue* currentQueue = nullptr;
+
+// every read is checked against the end of the record, the decoder feeds in records from files that may be cut short
+template<typename T>
+bool readValue(kengine::u8 const*& cursor, kengine::u8 const* end, T& value) {
+	if (static_cast<kengine::usize>(end - cursor) < sizeof(T)) {
+		cursor = end;
+		return false;
+	}
+
+	std::memcpy(&value, cursor, sizeof(T));
+	cursor += sizeof(T);
+	return true;
+}
+
+template<typename T>
+void appendInteger(std::string& out, T value) {
+	char digits[24];
+	std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+	out.append(digits, result.ptr);
+}
+
+// returns false once the arguments run out
+bool appendArgument(std::string& out, kengine::u8 const*& cursor, kengine::u8 const* end) {
+	if (cursor >= end) {
+		return false;
+	}
+
+	char text[64];
+	LogArgumentType type = static_cast<LogArgumentType>(*cursor++);
+	switch (type) {
+	case LogArgumentType::Bool: {
+		kengine::u8 value;
+		if (!readValue(cursor, end, value)) {
+			return false;
+		}
+		out += value != 0 ? "true" : "false";
+		break;
+	}
+	case LogArgumentType::Char: {
+		char value;
+		if (!readValue(cursor, end, value)) {
+			return false;
+		}
+		out += value;
+		break;
+	}
+	case LogArgumentType::Signed: {
+		kengine::s64 value;
+		if (!readValue(cursor, end, value)) {
+			return false;
+		}
+		appendInteger(out, value);
+		break;
+	}
+	case LogArgumentType::Unsigned: {
+		kengine::u64 value;
+		if (!readValue(cursor, end, value)) {
+			return false;
+		}
+		appendInteger(out, value);
+		break;
+	}
+	case LogArgumentType::Float: {
+		kengine::f64 value;
+		if (!readValue(cursor, end, value)) {
+			return false;
+		}
+		out.append(text, static_cast<kengine::usize>(std::snprintf(text, sizeof(text), "%g", value)));
+		break;
+	}
+	case LogArgumentType::Pointer: {
+		kengine::u64 value;
+		if (!readValue(cursor, end, value)) {
+			return false;
+		}
+		out.append(text, static_cast<kengine::usize>(std::snprintf(text, sizeof(text), "%p", reinterpret_cast<void*>(static_cast<std::uintptr_t>(value)))));
+		break;
+	}
+	case LogArgumentType::UUID: {
+		// same layout as UUID::toString
+		kengine::u64 uuid;
+		if (!readValue(cursor, end, uuid)) {
+			return false;
+		}
+		out.append(text, static_cast<kengine::usize>(std::snprintf(text, sizeof(text), "%llx-%llx-%llx", static_cast<unsigned long long>(uuid >> 48), static_cast<unsigned long long>((uuid >> 32) & 0xFFFF), static_cast<unsigned long long>(uuid & 0xFFFFFFFF))));
+		break;
+	}
+	case LogArgumentType::String: {
+		kengine::u16 length;
+		if (!readValue(cursor, end, length) || static_cast<kengine::usize>(end - cursor) < length) {
+			cursor = end;
+			return false;
+		}
+		out.append(reinterpret_cast<char const*>(cursor), length);
+		cursor += length;
+		break;
+	}
+	default:
+		// the padding at the end of the record, or an unknown tag in a corrupt one
+		cursor = end;
+		return false;
+	}
+
+	return true;
+}
+
+} // namespace
+
+kengine::u64 logTimestamp() {
+	return static_cast<kengine::u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void formatLogRecord(std::string& out, kengine::u8 const* record) {
+	LogRecord header;
+	std::memcpy(&header, record, sizeof(LogRecord));
+
+	kengine::u8 const* cursor = record + sizeof(LogRecord);
+	kengine::u8 const* end = record + std::max<kengine::usize>(header.size, sizeof(LogRecord));
+
+	if (header.layout != nullptr) {
+		LogFormatInfo const& layout = *header.layout;
+		for (kengine::usize i = 0; i < layout.argumentCount; ++i) {
+			out.append(layout.string + layout.segments[i].offset, layout.segments[i].length);
+			appendArgument(out, cursor, end);
+		}
+
+		LogFormatSegment const& last = layout.segments[layout.argumentCount];
+		out.append(layout.string + last.offset, last.length);
+		return;
+	}
+
+	char const* format = header.format;
+	for (char const* c = format; *c != '\0'; ++c) {
+		if (c[0] == '{' && c[1] == '}') {
+			out.append(format, c);
+			if (!appendArgument(out, cursor, end)) {
+				out += "{}";
+			}
+
+			format = c + 2;
+			++c;
+		}
+	}
+
+	out += format;
+}
+
+Logger::~Logger() {
+	stop();
+}
+
+void Logger::start() {
+	if (_running.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_sinkMutex);
+		if (logger == nullptr) {
+			logger = new StreamLogger(std::cout);
+		}
+	}
+
+	_running.store(true, std::memory_order_release);
+	_thread = std::thread(&Logger::_run, this);
+}
+
+void Logger::stop() {
+	if (!_running.exchange(false)) {
+		return;
+	}
+
+	_wake.notify_one();
+	_thread.join();
+
+	// a producer that saw the logger running may still be pushing, possibly waiting for queue space,
+	// so keep draining until every in-flight submit has landed
+	while (_submitting.load() != 0) {
+		_drain();
+		std::this_thread::yield();
+	}
+
+	_drain();
+}
+
+void Logger::flush() {
+	if (!_running.load(std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lock(_sinkMutex);
+		if (logger != nullptr) {
+			logger->flush();
+		}
+		return;
+	}
+
+	std::vector<std::pair<LogQueue*, kengine::u64>> targets;
+	{
+		std::lock_guard<std::mutex> lock(_queuesMutex);
+		for (std::unique_ptr<LogQueue>& queue : _queues) {
+			targets.emplace_back(queue.get(), queue->getHead());
+		}
+	}
+
+	_wake.notify_one();
+	for (auto const& [queue, head] : targets) {
+		while (queue->getTail() < head && _running.load(std::memory_order_acquire)) {
+			_wake.notify_one();
+			std::this_thread::yield();
+		}
+	}
+}
+
+void Logger::_submit(LogSeverity severity, kengine::u8 const* record, kengine::u32 size) {
+	// announced before _running is read, stop() either sees this submit or this submit sees the logger stopped
+	_submitting.fetch_add(1);
+	if (!_running.load()) {
+		_submitting.fetch_sub(1, std::memory_order_release);
+
+		std::lock_guard<std::mutex> lock(_sinkMutex);
+		if (logger == nullptr) {
+			logger = new StreamLogger(std::cout);
+		}
+
+		std::string line;
+		_write(record, line);
+		logger->flush();
+		return;
+	}
+
+	// a full queue means the logging thread fell behind, wait for it rather than lose the record
+	LogQueue& queue = _threadQueue();
+	while (!queue.push(record, size)) {
+		_wake.notify_one();
+		std::this_thread::yield();
+	}
+	_submitting.fetch_sub(1, std::memory_order_release);
+
+	if (severity == LogSeverity::Fatal) {
+		flush();
+	}
+}
+
+void Logger::_write(kengine::u8 const* record, std::string& line) {
+	if (logger->logRecord(record)) {
+		return;
+	}
+
+	LogRecord header;
+	std::memcpy(&header, record, sizeof(LogRecord));
+
+	line.clear();
+	formatLogRecord(line, record);
+	logger->log(header.severity, line);
+}
+
+LogQueue& Logger::_threadQueue() {
+	if (currentQueue == nullptr) {
+		std::lock_guard<std::mutex> lock(_queuesMutex);
+		_queues.push_back(std::make_unique<LogQueue>());
+		currentQueue = _queues.back().get();
+	}
+
+	return *currentQueue;
+}
+
+void Logger::_run() {
+	for (;;) {
+		bool running = _running.load(std::memory_order_acquire);
+		if (_drain() > 0) {
+			continue;
+		}
+
+		if (!running) {
+			break;
+		}
+
+		// producers never signal on the fast path, so poll at a short interval
+		std::unique_lock<std::mutex> lock(_wakeMutex);
+		_wake.wait_for(lock, std::chrono::milliseconds(1));
+	}
+}
+
+kengine::usize Logger::_drain() {
+	_batch.clear();
+	_batchRecords.clear();
+
+	_consumed.clear();
+	{
+		std::lock_guard<std::mutex> lock(_queuesMutex);
+		for (std::unique_ptr<LogQueue>& queue : _queues) {
+			kengine::u64 tail = queue->consume([this](kengine::u8 const* record) {
+				LogRecord header;
+				std::memcpy(&header, record, sizeof(LogRecord));
+
+				_batchRecords.push_back(_batch.size());
+				_batch.insert(_batch.end(), record, record + header.size);
+			});
+
+			_consumed.emplace_back(queue.get(), tail);
+		}
+	}
+
+	// each queue is already in order, interleave the threads by when they logged
+	std::stable_sort(_batchRecords.begin(), _batchRecords.end(), [this](kengine::usize a, kengine::usize b) {
+		kengine::u64 timeA, timeB;
+		std::memcpy(&timeA, _batch.data() + a + offsetof(LogRecord, time), sizeof(timeA));
+		std::memcpy(&timeB, _batch.data() + b + offsetof(LogRecord, time), sizeof(timeB));
+		return timeA < timeB;
+	});
+
+	if (!_batchRecords.empty()) {
+		std::lock_guard<std::mutex> lock(_sinkMutex);
+		for (kengine::usize offset : _batchRecords) {
+			_write(_batch.data() + offset, _line);
+		}
+
+		logger->flush();
+	}
+
+	// only now can the producers reuse the space, so flush() knows a released record was written
+	for (auto const& [queue, tail] : _consumed) {
+		queue->release(tail);
+	}
+
+	return _batchRecords.size();
+}
+
+} // namespace kengine::core
@@ -2,9 +2,24 @@
 
 #ifdef KENGINE_PLATFORM_LINUX
 
+#include <time.h>
+#include <errno.h>
+
 namespace kengine::core::platform::linux {
 
+namespace {
+
+// CLOCK_MONOTONIC_RAW is not slewed by NTP, so frame deltas stay exact
+kengine::s64 monotonicNanoseconds() {
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+	return static_cast<kengine::s64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+} // namespace
+
 bool PlatformLinux::init() {
+	_startNanoseconds = monotonicNanoseconds();
 	return true;
 }
 
@@ -16,8 +31,22 @@ bool PlatformLinux::update() {
 	return true;
 }
 
+// called from the main thread and the simulation job at once, so nothing is cached here
 kengine::f64 PlatformLinux::getTime() {
-	return 0;
+	return static_cast<kengine::f64>(monotonicNanoseconds() - _startNanoseconds) * 1e-9;
+}
+
+void PlatformLinux::sleep(kengine::f64 seconds) {
+	if (seconds <= 0.0) {
+		return;
+	}
+
+	timespec duration;
+	duration.tv_sec = static_cast<time_t>(seconds);
+	duration.tv_nsec = static_cast<long>((seconds - static_cast<kengine::f64>(duration.tv_sec)) * 1e9);
+
+	while (nanosleep(&duration, &duration) == -1 && errno == EINTR) {
+	}
 }
 
 } // namespace kengine::core::platform::linux
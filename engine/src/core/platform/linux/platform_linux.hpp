@@ -20,6 +20,10 @@ public:
 	virtual bool update() override;
 
 	virtual kengine::f64 getTime() override;
+	virtual void sleep(kengine::f64 seconds) override;
+
+private:
+	kengine::s64 _startNanoseconds = 0;
 };
 
 } // namespace kengine::core::platform::linux
@@ -10,7 +10,7 @@ namespace kengine::core::platform {
 Memory::~Memory() {
 	if (_allocationCount > 0 || !_allocations.empty()) {
 		std::stringstream sstream;
-		Logger::get().logf(LogSeverity::Error, "Memory::~Memory: Memory leaks detected ({} bytes, {} allocations)", _allocationSize, _allocationCount);
+		KENGINE_LOG(Memory, Error, "Memory::~Memory: Memory leaks detected ({} bytes, {} allocations)", _allocationSize, _allocationCount);
 		printAllocations(Logger::get().getLogger(), LogSeverity::Error);
 
 		KENGINE_DEBUG_BREAK();
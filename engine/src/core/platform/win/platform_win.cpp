@@ -5,15 +5,26 @@
 #ifdef KENGINE_PLATFORM_WINDOWS
 
 #include <Windows.h>
+#include <timeapi.h>
 
 namespace kengine::core::platform::win {
 
 bool PlatformWin::init() {
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+
+	_frequency = frequency.QuadPart;
+	_startCounter = counter.QuadPart;
+
+	// 1 ms scheduler granularity instead of the default ~15.6 ms, so sleep() is usable for frame pacing
+	timeBeginPeriod(1);
 	return true;
 }
 
 void PlatformWin::shutdown() {
-
+	timeEndPeriod(1);
 }
 
 bool PlatformWin::update() {
@@ -23,14 +34,26 @@ bool PlatformWin::update() {
 		DispatchMessageA(&msg);
 	}
 
-	Sleep(3);
 	return true;
 }
 
+// called from the main thread and the simulation job at once, so nothing is cached here
 kengine::f64 PlatformWin::getTime() {
-	return _time;
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+
+	kengine::s64 elapsed = counter.QuadPart - _startCounter;
+	return static_cast<kengine::f64>(elapsed / _frequency) + static_cast<kengine::f64>(elapsed % _frequency) / static_cast<kengine::f64>(_frequency);
+}
+
+void PlatformWin::sleep(kengine::f64 seconds) {
+	if (seconds <= 0.0) {
+		return;
+	}
+
+	Sleep(static_cast<DWORD>(seconds * 1000.0));
 }
 
 } // namespace kengine::core::platform::win
 
-#endif // KENGINE_PLATFORM_WINDOWS
\ No newline at end of file
+#endif // KENGINE_PLATFORM_WINDOWS
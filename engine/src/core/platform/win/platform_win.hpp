@@ -16,6 +16,11 @@ public:
 	bool update() override;
 
 	kengine::f64 getTime() override;
+	void sleep(kengine::f64 seconds) override;
+
+private:
+	kengine::s64 _frequency = 1;
+	kengine::s64 _startCounter = 0;
 };
 
 } // namespace kengine::core::platform::win
@@ -0,0 +1,189 @@
+#include <kengine/core/profiler.hpp>
+#include <kengine/core/logging.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace kengine::core {
+
+namespace {
+
+thread_local void* currentRing = nullptr;
+
+kengine::s64 steadyNanoseconds() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void writeEscaped(std::ofstream& out, char const* text) {
+	for (char const* c = text; *c != '\0'; ++c) {
+		if (*c == '"' || *c == '\\') {
+			out << '\\';
+		}
+		out << *c;
+	}
+}
+
+template<typename T>
+void writeValue(std::ofstream& out, T value) {
+	out.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+} // namespace
+
+thread_local kengine::u16 ProfileZone::_currentDepth = 0;
+
+Profiler::Profiler() {
+	_calibrationTicks = profilerTicks();
+	_calibrationNanoseconds = steadyNanoseconds();
+}
+
+Profiler::ThreadRing& Profiler::_threadRing() {
+	if (currentRing == nullptr) {
+		std::lock_guard<std::mutex> lock(_ringsMutex);
+		_rings.push_back(std::make_unique<ThreadRing>());
+		_rings.back()->thread = static_cast<kengine::u32>(_rings.size() - 1);
+		currentRing = _rings.back().get();
+	}
+
+	return *static_cast<ThreadRing*>(currentRing);
+}
+
+void Profiler::record(char const* name, kengine::u64 start, kengine::u64 end, kengine::u16 depth, ProfileEventType type) {
+	ThreadRing& ring = _threadRing();
+
+	// single producer, the exporter detects entries that were overwritten while it copied
+	kengine::u64 head = ring.head.load(std::memory_order_relaxed);
+	ring.events[head & (ringCapacity - 1)] = { name, start, end, depth, type };
+	ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::frame() {
+	if (!isEnabled()) {
+		return;
+	}
+
+	kengine::u64 now = profilerTicks();
+	record("Frame", now, now, 0, ProfileEventType::Frame);
+}
+
+kengine::f64 Profiler::getTicksPerSecond() {
+#ifdef KENGINE_PROFILER_RDTSC
+	kengine::u64 ticks = profilerTicks() - _calibrationTicks;
+	kengine::s64 nanoseconds = steadyNanoseconds() - _calibrationNanoseconds;
+	return nanoseconds > 0 ? static_cast<kengine::f64>(ticks) * 1e9 / static_cast<kengine::f64>(nanoseconds) : 1e9;
+#else
+	return 1e9;
+#endif
+}
+
+std::vector<Profiler::ThreadEvent> Profiler::_snapshot() {
+	std::vector<ThreadEvent> events;
+
+	std::lock_guard<std::mutex> lock(_ringsMutex);
+	for (std::unique_ptr<ThreadRing>& ring : _rings) {
+		kengine::u64 head = ring->head.load(std::memory_order_acquire);
+		kengine::u64 first = head > ringCapacity ? head - ringCapacity : 0;
+
+		kengine::usize offset = events.size();
+		for (kengine::u64 i = first; i < head; ++i) {
+			events.push_back({ ring->events[i & (ringCapacity - 1)], ring->thread });
+		}
+
+		// the owner kept writing while we copied, anything it lapped is torn
+		kengine::u64 after = ring->head.load(std::memory_order_acquire);
+		kengine::u64 overwritten = after > ringCapacity ? after - ringCapacity : 0;
+		if (overwritten > first) {
+			kengine::usize drop = static_cast<kengine::usize>(std::min(overwritten - first, head - first));
+			events.erase(events.begin() + offset, events.begin() + offset + drop);
+		}
+	}
+
+	std::sort(events.begin(), events.end(), [](ThreadEvent const& a, ThreadEvent const& b) {
+		return a.event.start < b.event.start;
+	});
+
+	return events;
+}
+
+bool Profiler::exportChromeTrace(std::string const& path) {
+	std::ofstream out(path);
+	if (!out.is_open()) {
+		KENGINE_LOG(Core, Error, "Profiler: failed to open {} for writing", path);
+		return false;
+	}
+
+	std::vector<ThreadEvent> events = _snapshot();
+	kengine::f64 microsecondsPerTick = 1e6 / getTicksPerSecond();
+	kengine::u64 origin = events.empty() ? 0 : events.front().event.start;
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	for (kengine::usize i = 0; i < events.size(); ++i) {
+		ProfileEvent const& event = events[i].event;
+		kengine::f64 timestamp = static_cast<kengine::f64>(event.start - origin) * microsecondsPerTick;
+
+		out << (i == 0 ? "\n" : ",\n") << "{\"name\":\"";
+		writeEscaped(out, event.name);
+		out << "\",\"pid\":0,\"tid\":" << events[i].thread << ",\"ts\":" << timestamp;
+
+		if (event.type == ProfileEventType::Frame) {
+			out << ",\"ph\":\"i\",\"s\":\"g\"}";
+		} else {
+			out << ",\"ph\":\"X\",\"dur\":" << static_cast<kengine::f64>(event.end - event.start) * microsecondsPerTick << "}";
+		}
+	}
+	out << "\n]}\n";
+
+	KENGINE_LOG(Core, Info, "Profiler: wrote {} events to {}", events.size(), path);
+	return true;
+}
+
+// layout, little endian:
+//   char[4] "KPRF", u32 version, f64 ticks per second, u32 name count, u64 event count
+//   per name:  u16 length, bytes
+//   per event: u32 name index, u32 thread, u64 start, u64 end, u16 depth, u8 type, u8 padding
+bool Profiler::exportBinary(std::string const& path) {
+	std::ofstream out(path, std::ios::binary);
+	if (!out.is_open()) {
+		KENGINE_LOG(Core, Error, "Profiler: failed to open {} for writing", path);
+		return false;
+	}
+
+	std::vector<ThreadEvent> events = _snapshot();
+
+	std::unordered_map<char const*, kengine::u32> nameIndices;
+	std::vector<char const*> names;
+	for (ThreadEvent const& event : events) {
+		if (nameIndices.emplace(event.event.name, static_cast<kengine::u32>(names.size())).second) {
+			names.push_back(event.event.name);
+		}
+	}
+
+	out.write("KPRF", 4);
+	writeValue<kengine::u32>(out, 1);
+	writeValue<kengine::f64>(out, getTicksPerSecond());
+	writeValue<kengine::u32>(out, static_cast<kengine::u32>(names.size()));
+	writeValue<kengine::u64>(out, events.size());
+
+	for (char const* name : names) {
+		kengine::u16 length = static_cast<kengine::u16>(std::min<kengine::usize>(std::strlen(name), 0xFFFF));
+		writeValue(out, length);
+		out.write(name, length);
+	}
+
+	for (ThreadEvent const& event : events) {
+		writeValue<kengine::u32>(out, nameIndices[event.event.name]);
+		writeValue<kengine::u32>(out, event.thread);
+		writeValue<kengine::u64>(out, event.event.start);
+		writeValue<kengine::u64>(out, event.event.end);
+		writeValue<kengine::u16>(out, event.event.depth);
+		writeValue<kengine::u8>(out, static_cast<kengine::u8>(event.event.type));
+		writeValue<kengine::u8>(out, 0);
+	}
+
+	KENGINE_LOG(Core, Info, "Profiler: wrote {} events to {}", events.size(), path);
+	return true;
+}
+
+} // namespace kengine::core
@@ -0,0 +1,471 @@
+#include <kengine/core/scene.hpp>
+#include <kengine/core/exception.hpp>
+#include <kengine/core/jobs/parallel.hpp>
+#include <kengine/core/profiler.hpp>
+#include <kengine/macros.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#ifdef KENGINE_SIMD_SSE2
+#include <xmmintrin.h>
+#endif
+
+namespace kengine::core {
+
+namespace {
+
+template<typename T>
+void reorderArray(std::vector<T>& values, std::vector<kengine::u32> const& order) {
+	std::vector<T> reordered;
+	reordered.reserve(order.size());
+	for (kengine::u32 index : order) {
+		reordered.push_back(values[index]);
+	}
+	values = std::move(reordered);
+}
+
+void multiply(kengine::f32 const* a, kengine::f32 const* b, kengine::f32* out) {
+#ifdef KENGINE_SIMD_SSE2
+	__m128 a0 = _mm_loadu_ps(a);
+	__m128 a1 = _mm_loadu_ps(a + 4);
+	__m128 a2 = _mm_loadu_ps(a + 8);
+	__m128 a3 = _mm_loadu_ps(a + 12);
+
+	for (kengine::usize column = 0; column < 4; ++column) {
+		kengine::f32 const* c = b + column * 4;
+		__m128 result = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(c[0])), _mm_mul_ps(a1, _mm_set1_ps(c[1]))),
+			_mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(c[2])), _mm_mul_ps(a3, _mm_set1_ps(c[3]))));
+		_mm_storeu_ps(out + column * 4, result);
+	}
+#else
+	kengine::f32 result[16];
+	for (kengine::usize column = 0; column < 4; ++column) {
+		for (kengine::usize row = 0; row < 4; ++row) {
+			result[column * 4 + row] = a[row] * b[column * 4] + a[4 + row] * b[column * 4 + 1] + a[8 + row] * b[column * 4 + 2] + a[12 + row] * b[column * 4 + 3];
+		}
+	}
+	std::memcpy(out, result, sizeof(result));
+#endif
+}
+
+void jobDispatch(void*, kengine::usize count, kengine::usize grain, SceneTask task, void* context) {
+	jobs::parallelFor(0, count, grain, [task, context](kengine::usize begin, kengine::usize end) {
+		task(context, begin, end);
+	});
+}
+
+} // namespace
+
+Scene::Scene() : _dispatcher(jobDispatch) {
+	_levels.push_back(0);
+}
+
+SceneNode Scene::create(SceneNode parent) {
+	kengine::u32 parentIndex = parent.isValid() ? getIndex(parent) : invalidIndex;
+	kengine::u32 depth = parentIndex == invalidIndex ? 0 : _depths[parentIndex] + 1;
+
+	kengine::u32 handle;
+	if (!_freeHandles.empty()) {
+		handle = _freeHandles.back();
+		_freeHandles.pop_back();
+	} else {
+		handle = static_cast<kengine::u32>(_handleToIndex.size());
+		_handleToIndex.push_back(invalidIndex);
+	}
+
+	kengine::u32 index = static_cast<kengine::u32>(_parents.size());
+
+	// appending only keeps depth order if the node lands on the last level or opens a new one
+	if (!_orderDirty) {
+		kengine::usize levelCount = _levels.size() - 1;
+		if (depth + 1 == levelCount) {
+			_levels.back() = index + 1;
+		} else if (depth == levelCount) {
+			_levels.push_back(index + 1);
+		} else {
+			_orderDirty = true;
+		}
+	}
+
+	_handleToIndex[handle] = index;
+	_indexToHandle.push_back(handle);
+
+	_positionX.push_back(0.0f);
+	_positionY.push_back(0.0f);
+	_positionZ.push_back(0.0f);
+	_rotationX.push_back(0.0f);
+	_rotationY.push_back(0.0f);
+	_rotationZ.push_back(0.0f);
+	_rotationW.push_back(1.0f);
+	_scaleX.push_back(1.0f);
+	_scaleY.push_back(1.0f);
+	_scaleZ.push_back(1.0f);
+
+	_parents.push_back(parentIndex);
+	_depths.push_back(depth);
+	_dirty.push_back(1);
+	_anyDirty = true;
+	_localMatrices.push_back(util::math::Matrix<f32, 4>::identity());
+	_worldMatrices.push_back(util::math::Matrix<f32, 4>::identity());
+
+	return SceneNode{ handle };
+}
+
+SceneNode Scene::create(Transform const& transform, SceneNode parent) {
+	SceneNode node = create(parent);
+	setTransform(node, transform);
+	return node;
+}
+
+void Scene::destroy(SceneNode node) {
+	if (_orderDirty) {
+		_sort();
+	}
+
+	kengine::u32 root = getIndex(node);
+
+	std::vector<kengine::u8> removed(_parents.size(), 0);
+	removed[root] = 1;
+	for (kengine::usize i = root + 1; i < _parents.size(); ++i) {
+		if (_parents[i] != invalidIndex && removed[_parents[i]]) {
+			removed[i] = 1;
+		}
+	}
+
+	std::vector<kengine::u32> order;
+	order.reserve(_parents.size());
+	for (kengine::u32 i = 0; i < _parents.size(); ++i) {
+		if (removed[i]) {
+			_handleToIndex[_indexToHandle[i]] = invalidIndex;
+			_freeHandles.push_back(_indexToHandle[i]);
+		} else {
+			order.push_back(i);
+		}
+	}
+
+	_reorder(order);
+}
+
+bool Scene::isAlive(SceneNode node) const {
+	return node.isValid() && node.id < _handleToIndex.size() && _handleToIndex[node.id] != invalidIndex;
+}
+
+kengine::u32 Scene::getIndex(SceneNode node) const {
+	if (!isAlive(node)) {
+		throw kengine::core::Exception("Scene: node {} does not exist", node.id);
+	}
+
+	return _handleToIndex[node.id];
+}
+
+SceneNode Scene::getParent(SceneNode node) const {
+	kengine::u32 parent = _parents[getIndex(node)];
+	return parent == invalidIndex ? SceneNode{} : SceneNode{ _indexToHandle[parent] };
+}
+
+void Scene::setParent(SceneNode node, SceneNode parent) {
+	kengine::u32 index = getIndex(node);
+	kengine::u32 parentIndex = parent.isValid() ? getIndex(parent) : invalidIndex;
+
+	for (kengine::u32 ancestor = parentIndex; ancestor != invalidIndex; ancestor = _parents[ancestor]) {
+		if (ancestor == index) {
+			throw kengine::core::Exception("Scene::setParent: node {} cannot be parented to its own descendant", node.id);
+		}
+	}
+
+	_parents[index] = parentIndex;
+	_dirty[index] = 1;
+	_anyDirty = true;
+
+	// a depth change moves the whole subtree to other levels
+	kengine::u32 depth = parentIndex == invalidIndex ? 0 : _depths[parentIndex] + 1;
+	if (depth != _depths[index]) {
+		_orderDirty = true;
+	}
+}
+
+util::math::Vector<f32, 3> Scene::getPosition(SceneNode node) const {
+	kengine::u32 index = getIndex(node);
+	return { _positionX[index], _positionY[index], _positionZ[index] };
+}
+
+util::math::Quaternion<f32> Scene::getRotation(SceneNode node) const {
+	kengine::u32 index = getIndex(node);
+	return { _rotationX[index], _rotationY[index], _rotationZ[index], _rotationW[index] };
+}
+
+util::math::Vector<f32, 3> Scene::getScale(SceneNode node) const {
+	kengine::u32 index = getIndex(node);
+	return { _scaleX[index], _scaleY[index], _scaleZ[index] };
+}
+
+void Scene::setPosition(SceneNode node, util::math::Vector<f32, 3> const& position) {
+	kengine::u32 index = getIndex(node);
+	_positionX[index] = position[0];
+	_positionY[index] = position[1];
+	_positionZ[index] = position[2];
+	_dirty[index] = 1;
+	_anyDirty = true;
+}
+
+void Scene::setRotation(SceneNode node, util::math::Quaternion<f32> const& rotation) {
+	kengine::u32 index = getIndex(node);
+	_rotationX[index] = rotation.x;
+	_rotationY[index] = rotation.y;
+	_rotationZ[index] = rotation.z;
+	_rotationW[index] = rotation.w;
+	_dirty[index] = 1;
+	_anyDirty = true;
+}
+
+void Scene::setScale(SceneNode node, util::math::Vector<f32, 3> const& scale) {
+	kengine::u32 index = getIndex(node);
+	_scaleX[index] = scale[0];
+	_scaleY[index] = scale[1];
+	_scaleZ[index] = scale[2];
+	_dirty[index] = 1;
+	_anyDirty = true;
+}
+
+void Scene::setTransform(SceneNode node, Transform const& transform) {
+	setPosition(node, transform.position);
+	setRotation(node, util::math::Quaternion<f32>::fromEuler(transform.rotation));
+	setScale(node, transform.scale);
+}
+
+void Scene::update() {
+	KENGINE_PROFILE_ZONE("Scene update");
+
+	if (_orderDirty) {
+		_sort();
+	}
+
+	if (!_anyDirty) {
+		return;
+	}
+
+	struct LevelContext {
+		Scene* scene;
+		kengine::usize offset;
+	};
+
+	LevelContext context = { this, 0 };
+
+	_dispatcher(_dispatcherData, _parents.size(), _grain, [](void* data, kengine::usize begin, kengine::usize end) {
+		LevelContext* level = static_cast<LevelContext*>(data);
+		level->scene->_computeLocalMatrices(level->offset + begin, level->offset + end);
+	}, &context);
+
+	// every parent of a level is in an earlier one, so a level's nodes are independent of each other
+	for (kengine::usize level = 0; level + 1 < _levels.size(); ++level) {
+		context.offset = _levels[level];
+
+		_dispatcher(_dispatcherData, _levels[level + 1] - _levels[level], _grain, [](void* data, kengine::usize begin, kengine::usize end) {
+			LevelContext* level = static_cast<LevelContext*>(data);
+			level->scene->_computeWorldMatrices(level->offset + begin, level->offset + end);
+		}, &context);
+	}
+
+	std::fill(_dirty.begin(), _dirty.end(), 0);
+	_anyDirty = false;
+}
+
+void Scene::setDispatcher(SceneDispatcher dispatcher, void* userData) {
+	_dispatcher = dispatcher != nullptr ? dispatcher : jobDispatch;
+	_dispatcherData = userData;
+}
+
+util::math::Matrix<f32, 4> const& Scene::getWorldMatrix(SceneNode node) const {
+	return _worldMatrices[getIndex(node)];
+}
+
+void Scene::_reorder(std::vector<kengine::u32> const& order) {
+	std::vector<kengine::u32> newIndex(_parents.size(), invalidIndex);
+	for (kengine::u32 i = 0; i < order.size(); ++i) {
+		newIndex[order[i]] = i;
+	}
+
+	reorderArray(_positionX, order);
+	reorderArray(_positionY, order);
+	reorderArray(_positionZ, order);
+	reorderArray(_rotationX, order);
+	reorderArray(_rotationY, order);
+	reorderArray(_rotationZ, order);
+	reorderArray(_rotationW, order);
+	reorderArray(_scaleX, order);
+	reorderArray(_scaleY, order);
+	reorderArray(_scaleZ, order);
+	reorderArray(_parents, order);
+	reorderArray(_depths, order);
+	reorderArray(_dirty, order);
+	reorderArray(_localMatrices, order);
+	reorderArray(_worldMatrices, order);
+	reorderArray(_indexToHandle, order);
+
+	for (kengine::u32& parent : _parents) {
+		if (parent != invalidIndex) {
+			parent = newIndex[parent];
+		}
+	}
+
+	for (kengine::u32 i = 0; i < _indexToHandle.size(); ++i) {
+		_handleToIndex[_indexToHandle[i]] = i;
+	}
+
+	_levels.clear();
+	for (kengine::u32 i = 0; i < _depths.size(); ++i) {
+		if (_depths[i] == _levels.size()) {
+			_levels.push_back(i);
+		}
+	}
+	_levels.push_back(static_cast<kengine::u32>(_depths.size()));
+}
+
+void Scene::_sort() {
+	kengine::usize count = _parents.size();
+
+	std::vector<kengine::u32> depth(count, invalidIndex);
+	std::vector<kengine::u32> chain;
+	for (kengine::u32 i = 0; i < count; ++i) {
+		kengine::u32 current = i;
+		while (current != invalidIndex && depth[current] == invalidIndex) {
+			chain.push_back(current);
+			current = _parents[current];
+		}
+
+		kengine::u32 base = current == invalidIndex ? 0 : depth[current] + 1;
+		while (!chain.empty()) {
+			depth[chain.back()] = base++;
+			chain.pop_back();
+		}
+	}
+
+	std::vector<kengine::u32> order(count);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&depth](kengine::u32 a, kengine::u32 b) {
+		return depth[a] < depth[b];
+	});
+
+	_depths = std::move(depth);
+	_reorder(order);
+	_orderDirty = false;
+}
+
+void Scene::_computeLocalMatrices(kengine::usize begin, kengine::usize end) {
+	kengine::usize i = begin;
+
+#ifdef KENGINE_SIMD_SSE2
+	// four nodes per iteration, lane n of every register belongs to node i + n
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 two = _mm_set1_ps(2.0f);
+	__m128 zero = _mm_setzero_ps();
+
+	for (; i + 4 <= end; i += 4) {
+		kengine::u32 dirty;
+		std::memcpy(&dirty, &_dirty[i], sizeof(dirty));
+		if (dirty == 0) {
+			continue;
+		}
+
+		__m128 x = _mm_loadu_ps(&_rotationX[i]);
+		__m128 y = _mm_loadu_ps(&_rotationY[i]);
+		__m128 z = _mm_loadu_ps(&_rotationZ[i]);
+		__m128 w = _mm_loadu_ps(&_rotationW[i]);
+		__m128 sx = _mm_loadu_ps(&_scaleX[i]);
+		__m128 sy = _mm_loadu_ps(&_scaleY[i]);
+		__m128 sz = _mm_loadu_ps(&_scaleZ[i]);
+
+		__m128 xx = _mm_mul_ps(x, x);
+		__m128 yy = _mm_mul_ps(y, y);
+		__m128 zz = _mm_mul_ps(z, z);
+		__m128 xy = _mm_mul_ps(x, y);
+		__m128 xz = _mm_mul_ps(x, z);
+		__m128 yz = _mm_mul_ps(y, z);
+		__m128 xw = _mm_mul_ps(x, w);
+		__m128 yw = _mm_mul_ps(y, w);
+		__m128 zw = _mm_mul_ps(z, w);
+
+		__m128 columns[4][4];
+		columns[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+		columns[0][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, zw)), sx);
+		columns[0][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, yw)), sx);
+		columns[0][3] = zero;
+
+		columns[1][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, zw)), sy);
+		columns[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+		columns[1][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, xw)), sy);
+		columns[1][3] = zero;
+
+		columns[2][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, yw)), sz);
+		columns[2][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, xw)), sz);
+		columns[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+		columns[2][3] = zero;
+
+		columns[3][0] = _mm_loadu_ps(&_positionX[i]);
+		columns[3][1] = _mm_loadu_ps(&_positionY[i]);
+		columns[3][2] = _mm_loadu_ps(&_positionZ[i]);
+		columns[3][3] = one;
+
+		// transposing turns "one element of four nodes" into "one column of one node"
+		for (kengine::usize column = 0; column < 4; ++column) {
+			__m128 r0 = columns[column][0];
+			__m128 r1 = columns[column][1];
+			__m128 r2 = columns[column][2];
+			__m128 r3 = columns[column][3];
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+			_mm_storeu_ps(_localMatrices[i].data() + column * 4, r0);
+			_mm_storeu_ps(_localMatrices[i + 1].data() + column * 4, r1);
+			_mm_storeu_ps(_localMatrices[i + 2].data() + column * 4, r2);
+			_mm_storeu_ps(_localMatrices[i + 3].data() + column * 4, r3);
+		}
+	}
+#endif
+
+	for (; i < end; ++i) {
+		if (!_dirty[i]) {
+			continue;
+		}
+
+		util::math::Quaternion<f32> rotation = { _rotationX[i], _rotationY[i], _rotationZ[i], _rotationW[i] };
+		util::math::Matrix<f32, 4>& local = _localMatrices[i];
+		local = rotation.toMatrix();
+
+		kengine::f32 scale[3] = { _scaleX[i], _scaleY[i], _scaleZ[i] };
+		for (kengine::usize column = 0; column < 3; ++column) {
+			for (kengine::usize row = 0; row < 3; ++row) {
+				local(row, column) *= scale[column];
+			}
+		}
+
+		local(0, 3) = _positionX[i];
+		local(1, 3) = _positionY[i];
+		local(2, 3) = _positionZ[i];
+	}
+}
+
+void Scene::_computeWorldMatrices(kengine::usize begin, kengine::usize end) {
+	for (kengine::usize i = begin; i < end; ++i) {
+		kengine::u32 parent = _parents[i];
+
+		// parents come first, so their flag already includes their own ancestors
+		if (parent != invalidIndex) {
+			_dirty[i] |= _dirty[parent];
+		}
+
+		if (!_dirty[i]) {
+			continue;
+		}
+
+		if (parent == invalidIndex) {
+			_worldMatrices[i] = _localMatrices[i];
+		} else {
+			multiply(_worldMatrices[parent].data(), _localMatrices[i].data(), _worldMatrices[i].data());
+		}
+	}
+}
+
+} // namespace kengine::core
@@ -0,0 +1,54 @@
+#include <kengine/core/timing.hpp>
+
+#include <algorithm>
+#include <thread>
+
+namespace kengine::core {
+
+kengine::u32 FixedTimestep::advance(kengine::f64 frameTime) {
+	_accumulator += std::max(frameTime, 0.0);
+
+	kengine::u32 steps = 0;
+	while (_accumulator >= _step && steps < _maxSteps) {
+		_accumulator -= _step;
+		++steps;
+	}
+
+	if (steps == _maxSteps) {
+		_accumulator = std::min(_accumulator, _step);
+	}
+
+	return steps;
+}
+
+void FramePacer::wait(platform::IPlatform& platform) {
+	if (_target <= 0.0) {
+		return;
+	}
+
+	kengine::f64 now = platform.getTime();
+	if (_deadline < 0.0) {
+		_deadline = now + _target;
+		return;
+	}
+
+	// more than a frame behind, start over from now instead of rushing to catch up
+	if (now > _deadline + _target) {
+		_deadline = now + _target;
+		return;
+	}
+
+	// the OS wakes us late by up to its timer granularity, so stop sleeping early and spin the rest
+	kengine::f64 remaining = _deadline - now;
+	if (remaining > _spin) {
+		platform.sleep(remaining - _spin);
+	}
+
+	while (platform.getTime() < _deadline) {
+		std::this_thread::yield();
+	}
+
+	_deadline += _target;
+}
+
+} // namespace kengine::core
@@ -0,0 +1,160 @@
+#include <kengine/core/jobs/job_system.hpp>
+#include <kengine/core/jobs/parallel.hpp>
+#include <kengine/core/logging.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace kengine::core;
+using namespace kengine::core::jobs;
+
+namespace {
+
+constexpr kengine::usize forkJoinJobs = 1 << 16;
+constexpr kengine::usize parallelForElements = 1 << 24;
+constexpr kengine::usize dagWidth = 256;
+constexpr kengine::usize dagDepth = 64;
+constexpr kengine::u32 rounds = 5;
+
+// results land here so the work is not optimized away
+volatile kengine::u64 spinSink;
+volatile double sumSink;
+
+// a few hundred nanoseconds of arithmetic, so scheduling overhead stays visible
+void spin(void* data) {
+	kengine::u64 value = reinterpret_cast<kengine::usize>(data);
+	for (kengine::u32 i = 0; i < 256; ++i) {
+		value = value * 6364136223846793005ull + 1442695040888963407ull;
+	}
+
+	// never true, but the compiler can't tell, and workers don't fight over the sink's cache line
+	if (value == 0) {
+		spinSink = value;
+	}
+}
+
+template<typename Function>
+double bestOf(Function&& function) {
+	double best = 1e30;
+	for (kengine::u32 i = 0; i < rounds; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		function();
+		auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+// many independent jobs joined by one counter
+double forkJoin() {
+	return bestOf([]() {
+		Counter counter;
+		for (kengine::usize i = 0; i < forkJoinJobs; ++i) {
+			JobSystem::get().run(&spin, reinterpret_cast<void*>(i), &counter);
+		}
+		JobSystem::get().wait(counter);
+	});
+}
+
+double parallelForSum(std::vector<float> const& values) {
+	return bestOf([&values]() {
+		double sum = parallelReduce(kengine::util::Span<float const>(values.data(), values.size()), 16384, 0.0, [&values](kengine::usize begin, kengine::usize end) {
+			double partial = 0.0;
+			for (kengine::usize i = begin; i < end; ++i) {
+				partial += static_cast<double>(values[i]) * values[i];
+			}
+			return partial;
+		}, [](double a, double b) {
+			return a + b;
+		});
+
+		sumSink = sum;
+	});
+}
+
+// dagDepth layers of dagWidth jobs, each released by its two neighbours in the layer above
+double dag() {
+	std::vector<Job*> previous(dagWidth);
+	std::vector<Job*> current(dagWidth);
+
+	return bestOf([&]() {
+		Counter counter;
+		for (kengine::usize layer = 0; layer < dagDepth; ++layer) {
+			for (kengine::usize i = 0; i < dagWidth; ++i) {
+				current[i] = JobSystem::get().create(&spin, reinterpret_cast<void*>(i), &counter);
+				if (layer > 0) {
+					JobSystem::get().addDependency(previous[i], current[i]);
+					JobSystem::get().addDependency(previous[(i + 1) % dagWidth], current[i]);
+				}
+			}
+
+			// the layer above is released only now, so no job can finish before its dependents are attached
+			if (layer > 0) {
+				for (Job* job : previous) {
+					JobSystem::get().submit(job);
+				}
+			}
+			std::swap(previous, current);
+		}
+
+		for (Job* job : previous) {
+			JobSystem::get().submit(job);
+		}
+		JobSystem::get().wait(counter);
+	});
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	// JobSystem reports through the logger, keep that out of the measurements
+	std::ostringstream discard;
+	Logger::get().init(discard);
+
+	kengine::u32 maxThreads = argc > 1 ? static_cast<kengine::u32>(std::atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+
+	std::vector<float> values(parallelForElements);
+	for (kengine::usize i = 0; i < values.size(); ++i) {
+		values[i] = static_cast<float>(i % 1024) * 0.001f;
+	}
+
+	std::printf("%8s %14s %8s %14s %8s %14s %8s\n", "threads", "fork-join ms", "speedup", "parallelFor ms", "speedup", "dag ms", "speedup");
+
+	double baseForkJoin = 0.0;
+	double baseParallelFor = 0.0;
+	double baseDag = 0.0;
+	for (kengine::u32 threads = 1; threads <= maxThreads; threads *= 2) {
+		// a single thread runs every job inline, which is the serial baseline
+		if (threads > 1) {
+			JobSystem::get().init({ threads - 1, false });
+		}
+
+		double forkJoinTime = forkJoin();
+		double parallelForTime = parallelForSum(values);
+		double dagTime = dag();
+
+		if (threads > 1) {
+			JobSystem::get().shutdown();
+		} else {
+			baseForkJoin = forkJoinTime;
+			baseParallelFor = parallelForTime;
+			baseDag = dagTime;
+		}
+
+		std::printf("%8u %14.3f %8.2f %14.3f %8.2f %14.3f %8.2f\n", threads,
+			forkJoinTime, baseForkJoin / forkJoinTime,
+			parallelForTime, baseParallelFor / parallelForTime,
+			dagTime, baseDag / dagTime);
+
+		if (threads < maxThreads && threads * 2 > maxThreads) {
+			threads = maxThreads / 2;
+		}
+	}
+
+	return 0;
+}
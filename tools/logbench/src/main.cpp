@@ -0,0 +1,135 @@
+#include <kengine/core/logging.hpp>
+#include <kengine/core/log_format.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+using namespace kengine::core;
+
+namespace {
+
+// small enough that one burst fits the calling thread's queue, so the producer never waits on the logging thread
+constexpr kengine::u32 burstSize = 256;
+constexpr kengine::u32 bursts = 2000;
+
+class NullLogger : public ILogger {
+public:
+	void log(LogSeverity, std::string const& message) override {
+		_characters += message.size();
+	}
+
+	kengine::usize getCharacters() const { return _characters; }
+
+private:
+	kengine::usize _characters = 0;
+};
+
+// the stringstream formatting logf did before the async logger, formatted on the calling thread
+namespace legacy {
+
+template<typename T>
+void value(std::stringstream& stream, T const& value) {
+	stream << value;
+}
+
+inline void value(std::stringstream& stream, bool const& value) {
+	stream << (value ? "true" : "false");
+}
+
+inline void concat(std::stringstream& stream, std::string const& format) {
+	stream << format;
+}
+
+template<typename T, typename... Args>
+void concat(std::stringstream& stream, std::string const& format, T const& first, Args const&... args) {
+	kengine::usize index = format.find("{}");
+	if (index == std::string::npos) {
+		stream << format;
+		return;
+	}
+
+	stream << format.substr(0, index);
+	value(stream, first);
+	concat(stream, format.substr(index + 2), args...);
+}
+
+template<typename... Args>
+void logf(ILogger& logger, LogSeverity severity, std::string const& format, Args const&... args) {
+	std::stringstream stream;
+	concat(stream, format, args...);
+	logger.log(severity, stream.str());
+}
+
+} // namespace legacy
+
+struct Result {
+	double callerNanoseconds;
+	double totalNanoseconds;
+};
+
+// caller time counts only the log calls, total time also waits for every record to reach the sink
+template<typename Function>
+Result measure(Function&& function) {
+	double caller = 0.0;
+	auto start = std::chrono::steady_clock::now();
+
+	for (kengine::u32 burst = 0; burst < bursts; ++burst) {
+		auto burstStart = std::chrono::steady_clock::now();
+		for (kengine::u32 i = 0; i < burstSize; ++i) {
+			function(burst * burstSize + i);
+		}
+		caller += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - burstStart).count();
+
+		Logger::get().flush();
+	}
+
+	double total = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	kengine::f64 calls = static_cast<kengine::f64>(burstSize) * bursts;
+	return { caller / calls, total / calls };
+}
+
+void print(char const* name, Result const& result) {
+	std::printf("%-34s %12.1f %12.1f\n", name, result.callerNanoseconds, result.totalNanoseconds);
+}
+
+} // namespace
+
+int main() {
+	// outlives the Logger singleton, which is created after it
+	static NullLogger sink;
+	Logger::get().init(&sink);
+
+	std::string const name = "player";
+	double const health = 87.5;
+	std::string const format = "frame {} entity {} health {} alive {}";
+
+	std::printf("%-34s %12s %12s\n", "path", "caller ns", "total ns");
+
+	print("stringstream logf (before 042)", measure([&](kengine::u32 i) {
+		legacy::logf(sink, LogSeverity::Info, "frame {} entity {} health {} alive {}", i, name, health, true);
+	}));
+
+	Logger::get().start();
+
+	// a literal binds to the char array overload and is queued like KENGINE_FMT, only unchecked
+	print("literal format", measure([&](kengine::u32 i) {
+		Logger::get().logf(LogSeverity::Info, "frame {} entity {} health {} alive {}", i, name, health, true);
+	}));
+
+	// a std::string format is only known at runtime, it is resolved on the calling thread
+	print("runtime format string", measure([&](kengine::u32 i) {
+		Logger::get().logf(LogSeverity::Info, format, i, name, health, true);
+	}));
+
+	print("KENGINE_FMT", measure([&](kengine::u32 i) {
+		Logger::get().logf(LogSeverity::Info, KENGINE_FMT("frame {} entity {} health {} alive {}"), i, name, health, true);
+	}));
+
+	Logger::get().stop();
+
+	// keeps the sink's work observable
+	std::printf("%zu characters formatted\n", sink.getCharacters());
+	return 0;
+}
@@ -0,0 +1,177 @@
+#include <kengine/core/binary_logger.hpp>
+#include <kengine/core/logging.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace kengine::core;
+
+namespace {
+
+struct LogFile {
+	std::string path;
+	BinaryLogHeader header;
+	std::vector<kengine::u8> data;
+};
+
+template<typename T>
+bool readValue(std::vector<kengine::u8> const& data, kengine::usize& offset, T& value) {
+	if (offset + sizeof(T) > data.size()) {
+		return false;
+	}
+
+	std::memcpy(&value, data.data() + offset, sizeof(T));
+	offset += sizeof(T);
+	return true;
+}
+
+bool load(std::string const& path, LogFile& file) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in.is_open()) {
+		std::cerr << "logdecode: cannot open " << path << '\n';
+		return false;
+	}
+
+	file.path = path;
+	file.data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+	kengine::usize offset = 0;
+	if (!readValue(file.data, offset, file.header) || std::memcmp(file.header.magic, "KLOG", 4) != 0) {
+		std::cerr << "logdecode: " << path << " is not a binary log\n";
+		return false;
+	}
+
+	if (file.header.version != binaryLogVersion) {
+		std::cerr << "logdecode: " << path << " has version " << file.header.version << ", expected " << binaryLogVersion << '\n';
+		return false;
+	}
+
+	return true;
+}
+
+void writeTime(std::ostream& out, BinaryLogHeader const& header, kengine::u64 time) {
+	kengine::u64 system = header.systemNanoseconds + (time - header.steadyNanoseconds);
+	std::time_t seconds = static_cast<std::time_t>(system / 1000000000);
+
+	char text[32];
+	std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", std::localtime(&seconds));
+
+	char fraction[16];
+	std::snprintf(fraction, sizeof(fraction), ".%06llu", static_cast<unsigned long long>((system % 1000000000) / 1000));
+	out << text << fraction;
+}
+
+bool truncated(LogFile const& file) {
+	std::cerr << "logdecode: " << file.path << " ends in a truncated entry\n";
+	return false;
+}
+
+bool decode(LogFile const& file, std::ostream& out) {
+	StreamLogger severities(out);
+	std::vector<std::string> formats;
+	std::vector<kengine::u8> record;
+	std::string message;
+	std::string severity;
+
+	kengine::usize offset = sizeof(BinaryLogHeader);
+	while (offset < file.data.size()) {
+		BinaryLogEntry kind = static_cast<BinaryLogEntry>(file.data[offset]);
+
+		if (kind == BinaryLogEntry::End) {
+			return true;
+		}
+
+		if (kind == BinaryLogEntry::Format) {
+			kengine::u8 padding;
+			kengine::u16 length;
+			kengine::u32 id;
+			kengine::usize cursor = offset + 1;
+			if (!readValue(file.data, cursor, padding) || !readValue(file.data, cursor, length) || !readValue(file.data, cursor, id) || cursor + length > file.data.size()) {
+				return truncated(file);
+			}
+
+			if (id >= formats.size()) {
+				formats.resize(id + 1);
+			}
+			formats[id].assign(reinterpret_cast<char const*>(file.data.data() + cursor), length);
+
+			offset = cursor + length;
+			continue;
+		}
+
+		if (kind != BinaryLogEntry::Record) {
+			std::cerr << "logdecode: " << file.path << ": unknown entry " << static_cast<int>(kind) << " at offset " << offset << '\n';
+			return false;
+		}
+
+		kengine::s8 level;
+		kengine::u16 argumentSize;
+		kengine::u32 id;
+		kengine::u64 time;
+		kengine::usize cursor = offset + 1;
+		if (!readValue(file.data, cursor, level) || !readValue(file.data, cursor, argumentSize) || !readValue(file.data, cursor, id) || !readValue(file.data, cursor, time) || cursor + argumentSize > file.data.size()) {
+			return truncated(file);
+		}
+
+		if (id >= formats.size()) {
+			std::cerr << "logdecode: " << file.path << ": record at offset " << offset << " uses undefined format " << id << '\n';
+			return false;
+		}
+
+		// rebuild the in-memory record so the engine's own formatter turns it into text
+		LogRecord header = { static_cast<kengine::u32>(sizeof(LogRecord) + argumentSize), static_cast<LogSeverity>(level), formats[id].c_str(), nullptr, time };
+		record.resize(header.size);
+		std::memcpy(record.data(), &header, sizeof(LogRecord));
+		std::memcpy(record.data() + sizeof(LogRecord), file.data.data() + cursor, argumentSize);
+
+		message.clear();
+		formatLogRecord(message, record.data());
+		severities.severityAsString(header.severity, severity);
+
+		writeTime(out, file.header, time);
+		out << " [" << severity << "] " << message << '\n';
+
+		offset = cursor + argumentSize;
+	}
+
+	return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cerr << "usage: kengine_logdecode <file.klog>...\n";
+		return 1;
+	}
+
+	std::vector<LogFile> files;
+	for (int i = 1; i < argc; ++i) {
+		LogFile file;
+		if (!load(argv[i], file)) {
+			return 1;
+		}
+		files.push_back(std::move(file));
+	}
+
+	// a rotated set decodes oldest first whatever order the shell listed it in, files left over from an earlier run included
+	std::sort(files.begin(), files.end(), [](LogFile const& a, LogFile const& b) {
+		if (a.header.systemNanoseconds != b.header.systemNanoseconds) {
+			return a.header.systemNanoseconds < b.header.systemNanoseconds;
+		}
+		return a.header.sequence < b.header.sequence;
+	});
+
+	bool ok = true;
+	for (LogFile const& file : files) {
+		ok = decode(file, std::cout) && ok;
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+#include <kengine/core/graphics/mesh_optimizer.hpp>
+#include <kengine/core/graphics/mesh_simplifier.hpp>
+#include <kengine/core/logging.hpp>
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace kengine::core;
+using namespace kengine::core::graphics;
+
+namespace {
+
+struct Options {
+	std::string input;
+	std::string output;
+	kengine::u32 lodLevels = 0;
+	kengine::f32 reduction = 0.5f;
+};
+
+// an OBJ index is 1-based, negative ones count back from the latest element, 0 means absent
+bool resolveIndex(long index, kengine::usize count, kengine::usize& resolved) {
+	if (index > 0 && static_cast<kengine::usize>(index) <= count) {
+		resolved = static_cast<kengine::usize>(index - 1);
+		return true;
+	}
+
+	if (index < 0 && static_cast<kengine::usize>(-index) <= count) {
+		resolved = count - static_cast<kengine::usize>(-index);
+		return true;
+	}
+
+	return false;
+}
+
+// positions, texcoords and normals of a Wavefront OBJ, polygons are triangulated as fans
+bool loadObj(std::string const& path, MeshData& mesh) {
+	std::ifstream in(path);
+	if (!in.is_open()) {
+		std::cerr << "meshopt: cannot open " << path << '\n';
+		return false;
+	}
+
+	std::vector<std::array<kengine::f32, 3>> positions;
+	std::vector<std::array<kengine::f32, 2>> texCoords;
+	std::vector<std::array<kengine::f32, 3>> normals;
+
+	// one vertex per distinct position/texcoord/normal triple
+	std::map<std::array<kengine::usize, 3>, kengine::u32> corners;
+
+	std::string line;
+	kengine::usize lineNumber = 0;
+	while (std::getline(in, line)) {
+		++lineNumber;
+
+		std::istringstream stream(line);
+		std::string keyword;
+		stream >> keyword;
+
+		if (keyword == "v") {
+			std::array<kengine::f32, 3> position = {};
+			stream >> position[0] >> position[1] >> position[2];
+			positions.push_back(position);
+		} else if (keyword == "vt") {
+			std::array<kengine::f32, 2> texCoord = {};
+			stream >> texCoord[0] >> texCoord[1];
+			texCoords.push_back(texCoord);
+		} else if (keyword == "vn") {
+			std::array<kengine::f32, 3> normal = {};
+			stream >> normal[0] >> normal[1] >> normal[2];
+			normals.push_back(normal);
+		} else if (keyword == "f") {
+			std::vector<kengine::u32> polygon;
+			std::string corner;
+			while (stream >> corner) {
+				long parts[3] = { 0, 0, 0 };
+				char const* cursor = corner.c_str();
+				for (kengine::usize part = 0; part < 3 && *cursor != '\0'; ++part) {
+					char* end = nullptr;
+					parts[part] = std::strtol(cursor, &end, 10);
+					cursor = *end == '/' ? end + 1 : end;
+				}
+
+				// missing attributes resolve to an index past the end and are left zeroed
+				std::array<kengine::usize, 3> key = { 0, texCoords.size(), normals.size() };
+				if (!resolveIndex(parts[0], positions.size(), key[0])) {
+					std::cerr << "meshopt: " << path << ':' << lineNumber << ": invalid position index in " << corner << '\n';
+					return false;
+				}
+
+				if (parts[1] != 0 && !resolveIndex(parts[1], texCoords.size(), key[1])) {
+					std::cerr << "meshopt: " << path << ':' << lineNumber << ": invalid texcoord index in " << corner << '\n';
+					return false;
+				}
+
+				if (parts[2] != 0 && !resolveIndex(parts[2], normals.size(), key[2])) {
+					std::cerr << "meshopt: " << path << ':' << lineNumber << ": invalid normal index in " << corner << '\n';
+					return false;
+				}
+
+				auto inserted = corners.emplace(key, static_cast<kengine::u32>(mesh.vertices.size()));
+				if (inserted.second) {
+					Vertex vertex = {};
+					vertex.position = { positions[key[0]][0], positions[key[0]][1], positions[key[0]][2] };
+					if (key[1] < texCoords.size()) {
+						vertex.texCoords = { texCoords[key[1]][0], texCoords[key[1]][1] };
+					}
+
+					if (key[2] < normals.size()) {
+						vertex.normal = { normals[key[2]][0], normals[key[2]][1], normals[key[2]][2] };
+					}
+
+					mesh.vertices.push_back(vertex);
+				}
+
+				polygon.push_back(inserted.first->second);
+			}
+
+			for (kengine::usize i = 2; i < polygon.size(); ++i) {
+				mesh.indices.push_back(polygon[0]);
+				mesh.indices.push_back(polygon[i - 1]);
+				mesh.indices.push_back(polygon[i]);
+			}
+		}
+	}
+
+	if (mesh.indices.empty()) {
+		std::cerr << "meshopt: " << path << " has no faces\n";
+		return false;
+	}
+
+	return true;
+}
+
+// every LOD indexes the same vertices, each one is written as its own group
+bool saveObj(std::string const& path, MeshData const& mesh, std::vector<MeshLOD> const& lods) {
+	std::ofstream out(path);
+	if (!out.is_open()) {
+		std::cerr << "meshopt: cannot write " << path << '\n';
+		return false;
+	}
+
+	char line[128];
+	for (Vertex const& vertex : mesh.vertices) {
+		std::snprintf(line, sizeof(line), "v %.9g %.9g %.9g\n", vertex.position[0], vertex.position[1], vertex.position[2]);
+		out << line;
+	}
+
+	for (Vertex const& vertex : mesh.vertices) {
+		std::snprintf(line, sizeof(line), "vt %.9g %.9g\n", vertex.texCoords[0], vertex.texCoords[1]);
+		out << line;
+	}
+
+	for (Vertex const& vertex : mesh.vertices) {
+		std::snprintf(line, sizeof(line), "vn %.9g %.9g %.9g\n", vertex.normal[0], vertex.normal[1], vertex.normal[2]);
+		out << line;
+	}
+
+	for (kengine::usize level = 0; level < lods.size(); ++level) {
+		MeshLOD const& lod = lods[level];
+		out << "# lod " << level << " error " << lod.error << '\n';
+		out << "g lod" << level << '\n';
+
+		for (kengine::u32 i = lod.firstIndex; i + 2 < lod.firstIndex + lod.indexCount; i += 3) {
+			out << 'f';
+			for (kengine::u32 corner = 0; corner < 3; ++corner) {
+				kengine::u32 index = mesh.indices[i + corner] + 1;
+				out << ' ' << index << '/' << index << '/' << index;
+			}
+			out << '\n';
+		}
+	}
+
+	return static_cast<bool>(out);
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--lods") == 0 && i + 1 < argc) {
+			options.lodLevels = static_cast<kengine::u32>(std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--reduction") == 0 && i + 1 < argc) {
+			options.reduction = static_cast<kengine::f32>(std::atof(argv[++i]));
+		} else if (argv[i][0] == '-') {
+			return false;
+		} else {
+			paths.push_back(argv[i]);
+		}
+	}
+
+	if (paths.size() != 2 || options.reduction <= 0.0f || options.reduction >= 1.0f) {
+		return false;
+	}
+
+	options.input = paths[0];
+	options.output = paths[1];
+	return true;
+}
+
+} // namespace
+
+// welds, reorders for the vertex cache, overdraw and vertex fetch, and optionally appends a LOD chain,
+// so import pipelines can bake the result instead of paying for it at load time
+int main(int argc, char** argv) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		std::cerr << "usage: kengine_meshopt <input.obj> <output.obj> [--lods <levels>] [--reduction <0..1>]\n";
+		return 1;
+	}
+
+	// the optimizer reports through the logger, the summary below is all the tool prints
+	std::ostringstream discard;
+	Logger::get().init(discard);
+
+	MeshData mesh;
+	if (!loadObj(options.input, mesh)) {
+		return 1;
+	}
+
+	kengine::usize triangles = mesh.indices.size() / 3;
+	MeshOptimizationStats stats = optimizeMesh(mesh);
+
+	std::vector<MeshLOD> lods;
+	if (options.lodLevels > 0) {
+		lods = generateLODs(mesh, options.lodLevels, options.reduction);
+	} else {
+		lods.push_back({ 0, static_cast<kengine::u32>(mesh.indices.size()), 0.0f });
+	}
+
+	if (!saveObj(options.output, mesh, lods)) {
+		return 1;
+	}
+
+	std::printf("%zu triangles, vertices %zu -> %zu, ACMR %.3f -> %.3f\n", triangles, stats.vertexCountBefore, stats.vertexCountAfter, stats.acmrBefore, stats.acmrAfter);
+	for (kengine::usize level = 1; level < lods.size(); ++level) {
+		std::printf("lod %zu: %u triangles, error %g\n", level, lods[level].indexCount / 3, lods[level].error);
+	}
+
+	return 0;
+}